@@ -0,0 +1,222 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <limits>
+#include "AnalysisCache.h"
+#include "ChessEngineInterface.h"
+#include "UCIInfo.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+const char MAGIC[8] = {'A', 'N', 'C', 'A', 'C', 'H', 'E', '3'};
+
+// a line in UCI notation into moves padded with null moves, false if a
+// word is not a move or the line does not fit
+bool PackLine(const string & line, uint16_t * out, size_t size) {
+  memset(out, 0, size * sizeof(uint16_t));
+  size_t num_moves = 0;
+  size_t start = line.find_first_not_of(' ');
+  while(start != string::npos) {
+    size_t end = line.find(' ', start);
+    if(end == string::npos) {
+      end = line.size();
+    }
+    PackedMove move = UCIInfo::ParseMove(TextSpan(line.data() + start, end - start));
+    if(move.IsNull() || num_moves == size) {
+      return false;
+    }
+    out[num_moves++] = move.GetData();
+    start = line.find_first_not_of(' ', end);
+  }
+  return true;
+}
+
+string UnpackLine(const uint16_t * moves, size_t size) {
+  string line;
+  for(size_t i = 0; i < size && moves[i] != 0; ++i) {
+    PackedMove move(moves[i] & 0x3f, (moves[i] >> 6) & 0x3f, moves[i] >> 12);
+    line += (line.empty() ? "" : " ") + move.UCI();
+  }
+  return line;
+}
+
+// limits are stored in smaller fields, a limit too big for its field is
+// stored lower, so the entry is only used for searches it covers
+template <typename T>
+T Clamp(long value) {
+  return (value > static_cast<long>(numeric_limits<T>::max())) ?
+      numeric_limits<T>::max() : static_cast<T>(value);
+}
+
+// an entry limit covers the requested one if it is the same or higher,
+// 0 is no limit
+bool CoversLimit(long entry, long requested) {
+  return (entry == 0) || (requested != 0 && entry >= requested);
+}
+
+}
+
+AnalysisCache::AnalysisCache(const string & filename, size_t size_mb) :
+  fd_(-1), data_(nullptr), size_(0), entries_(nullptr), num_entries_(0) {
+  fd_ = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+  if(fd_ == -1) {
+    return;
+  }
+  if(flock(fd_, LOCK_EX | LOCK_NB) == -1) {
+    return;
+  }
+
+  struct stat file_stat;
+  if(fstat(fd_, &file_stat) == -1) {
+    return;
+  }
+
+  bool is_new = (file_stat.st_size == 0);
+  if(is_new) {
+    // biggest power of two number of buckets that fits
+    size_t num_buckets = 1;
+    while(num_buckets * 2 * BUCKET_SIZE * sizeof(Entry) <= size_mb * 1024 * 1024) {
+      num_buckets *= 2;
+    }
+    size_ = sizeof(Header) + num_buckets * BUCKET_SIZE * sizeof(Entry);
+    // the file is filled with zeros, which are empty entries
+    if(ftruncate(fd_, size_) == -1) {
+      return;
+    }
+  } else {
+    size_ = file_stat.st_size;
+    if(size_ < sizeof(Header)) {
+      return;
+    }
+  }
+
+  data_ = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if(data_ == MAP_FAILED) {
+    data_ = nullptr;
+    return;
+  }
+
+  Header * header = static_cast<Header *>(data_);
+  if(is_new) {
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->num_entries = (size_ - sizeof(Header)) / sizeof(Entry);
+  } else if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            sizeof(Header) + header->num_entries * sizeof(Entry) != size_) {
+    // not a cache file, it is left as it is
+    return;
+  }
+  num_entries_ = header->num_entries;
+  entries_ = reinterpret_cast<Entry *>(header + 1);
+}
+
+AnalysisCache::~AnalysisCache() {
+  if(data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  if(fd_ != -1) {
+    close(fd_);
+  }
+}
+
+// a search with the limits of the entry was at least as long as one with
+// the requested limits
+bool AnalysisCache::Covers(const Entry & entry, const SearchLimits & limits) {
+  if(!CoversLimit(entry.movetime_ms, limits.movetime_ms) ||
+     !CoversLimit(entry.nodes, limits.nodes) ||
+     !CoversLimit(entry.limit_depth, limits.depth)) {
+    return false;
+  }
+  // an adaptive stop shortens the search
+  return entry.stable_iterations == 0 ||
+         (limits.stable_iterations > 0 &&
+          entry.stable_iterations >= limits.stable_iterations &&
+          entry.stable_margin <= limits.stable_margin);
+}
+
+bool AnalysisCache::Find(uint64_t key, uint32_t engine,
+    const SearchLimits & limits, Evaluation & evaluation) {
+  if(entries_ == nullptr) {
+    return false;
+  }
+
+  lock_guard<mutex> lock(mutex_);
+  Entry * bucket = entries_ + (key & (num_entries_ / BUCKET_SIZE - 1)) * BUCKET_SIZE;
+  for(size_t i = 0; i < BUCKET_SIZE; ++i) {
+    const Entry & entry = bucket[i];
+    if(entry.key == key && entry.engine == engine && Covers(entry, limits)) {
+      evaluation.score = entry.score;
+      evaluation.mate = GetMate(entry.score);
+      evaluation.depth = entry.depth;
+      evaluation.best = UnpackLine(&entry.best, 1);
+      evaluation.line = UnpackLine(entry.line, LINE_SIZE);
+      return true;
+    }
+  }
+  return false;
+}
+
+void AnalysisCache::Store(uint64_t key, uint32_t engine,
+    const SearchLimits & limits, const Evaluation & evaluation) {
+  if(entries_ == nullptr) {
+    return;
+  }
+
+  uint16_t best = 0;
+  uint16_t line[LINE_SIZE];
+  if(!PackLine(evaluation.best, &best, 1) ||
+     !PackLine(evaluation.line, line, LINE_SIZE)) {
+    return;
+  }
+
+  lock_guard<mutex> lock(mutex_);
+  Entry * bucket = entries_ + (key & (num_entries_ / BUCKET_SIZE - 1)) * BUCKET_SIZE;
+  // the same position, else an empty entry, else the lowest depth
+  Entry * entry = bucket;
+  for(size_t i = 0; i < BUCKET_SIZE; ++i) {
+    if(bucket[i].key == key && bucket[i].engine == engine) {
+      entry = &bucket[i];
+      break;
+    }
+    if(bucket[i].depth < entry->depth) {
+      entry = &bucket[i];
+    }
+  }
+
+  entry->key = key;
+  entry->engine = engine;
+  entry->score = evaluation.score;
+  entry->movetime_ms = Clamp<uint32_t>(limits.movetime_ms);
+  entry->nodes = Clamp<uint32_t>(limits.nodes);
+  entry->limit_depth = Clamp<uint8_t>(limits.depth);
+  entry->stable_iterations = Clamp<uint8_t>(limits.stable_iterations);
+  entry->stable_margin = Clamp<uint16_t>(limits.stable_margin);
+  entry->depth = Clamp<uint16_t>(evaluation.depth);
+  entry->best = best;
+  memcpy(entry->line, line, sizeof(entry->line));
+}
+
+// FNV-1a
+uint32_t AnalysisCache::GetEngineId(const string & name) {
+  uint32_t id = 2166136261u;
+  for(char c : name) {
+    id = (id ^ static_cast<unsigned char>(c)) * 16777619u;
+  }
+  return id;
+}
+
+}
+}
@@ -0,0 +1,92 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef ANALYSISCACHE_H_
+#define ANALYSISCACHE_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace acortes {
+namespace chess {
+
+struct Evaluation;
+struct SearchLimits;
+
+// Engine results kept in a file mapped in memory, so they survive from
+// one run to the next. Positions are found by their Zobrist key, which
+// is the same in every run. Results of a different engine, or of a
+// search with lower limits than the one requested, are not used.
+// The file is locked while it is open, only one process can use it at a
+// time. Threads of that process can share it.
+class AnalysisCache {
+public:
+  // a new file is created with size_mb megabytes, an existing one keeps
+  // its size
+  AnalysisCache(const std::string & filename, size_t size_mb);
+  ~AnalysisCache();
+  bool IsOpen() const { return entries_ != nullptr; }
+  // true if there is a result for the position of a search at least as
+  // long as one with the given limits
+  bool Find(uint64_t key, uint32_t engine, const SearchLimits & limits,
+      Evaluation & evaluation);
+  // a result whose line is too long to be kept whole is not stored, so a
+  // result found is the same the engine gave
+  void Store(uint64_t key, uint32_t engine, const SearchLimits & limits,
+      const Evaluation & evaluation);
+  size_t GetNumEntries() const { return num_entries_; }
+  // identifier of an engine from its "id name", which has the version
+  static uint32_t GetEngineId(const std::string & name);
+
+private:
+  static const size_t BUCKET_SIZE = 4;
+  // moves, more than the engine interface keeps, see UCIInfo
+  static const size_t LINE_SIZE = 48;
+
+  // two cache lines per entry. Moves are kept as in a PackedMove,
+  // without flags, and the line is padded with null moves.
+  struct Entry {
+    uint64_t key;
+    uint32_t engine;
+    // light side point of view
+    int32_t score;
+    // limits of the search, see SearchLimits
+    uint32_t movetime_ms;
+    uint32_t nodes;
+    uint8_t limit_depth;
+    uint8_t stable_iterations;
+    uint16_t stable_margin;
+    // depth reached
+    uint16_t depth;
+    uint16_t best;
+    uint16_t line[LINE_SIZE];
+  };
+  static_assert(sizeof(Entry) == 128, "an entry is two cache lines");
+
+  struct Header {
+    char magic[8];
+    uint64_t num_entries;
+    char unused[48];
+  };
+
+  int fd_;
+  void * data_;
+  size_t size_;
+  Entry * entries_;
+  size_t num_entries_;
+  std::mutex mutex_;
+
+  static bool Covers(const Entry & entry, const SearchLimits & limits);
+
+  AnalysisCache(const AnalysisCache &);
+  AnalysisCache & operator=(const AnalysisCache &);
+};
+
+}
+}
+
+#endif /* ANALYSISCACHE_H_ */
@@ -0,0 +1,93 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include "AnalysisCheckpoint.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+// the file has the line "output <size>", then one line "<games> <path>"
+// for each PGN file, the path goes to the end of the line
+
+AnalysisCheckpoint::AnalysisCheckpoint(const string & filename) :
+  filename_(filename), output_size_(0) {
+}
+
+bool AnalysisCheckpoint::Load() {
+  ifstream file(filename_);
+  string word;
+  uint64_t output_size = 0;
+  if(!(file >> word >> output_size) || word != "output") {
+    return false;
+  }
+
+  map<string, size_t> games_done;
+  size_t num_games = 0;
+  while(file >> num_games) {
+    string pgnfile;
+    file.get();
+    if(!getline(file, pgnfile) || pgnfile.empty()) {
+      return false;
+    }
+    games_done[pgnfile] = num_games;
+  }
+  if(!file.eof()) {
+    return false;
+  }
+
+  games_done_.swap(games_done);
+  output_size_ = output_size;
+  return true;
+}
+
+bool AnalysisCheckpoint::Save() const {
+  string temporary = filename_ + ".tmp";
+  {
+    ofstream file(temporary, ios::trunc);
+    file << "output " << output_size_ << "\n";
+    for(const auto & games : games_done_) {
+      file << games.second << " " << games.first << "\n";
+    }
+    if(!file.flush()) {
+      return false;
+    }
+  }
+  // the new file is on disk before it replaces the old one, and the
+  // directory after it does
+  if(!SyncFile(temporary) || rename(temporary.c_str(), filename_.c_str()) != 0) {
+    return false;
+  }
+  size_t slash = filename_.find_last_of('/');
+  return SyncFile((slash == string::npos) ? "." : filename_.substr(0, slash + 1));
+}
+
+bool AnalysisCheckpoint::SyncFile(const string & path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    return false;
+  }
+  bool is_synced = fsync(fd) == 0;
+  close(fd);
+  return is_synced;
+}
+
+size_t AnalysisCheckpoint::GetNumGamesDone(const string & pgnfile) const {
+  auto games = games_done_.find(pgnfile);
+  return (games != games_done_.end()) ? games->second : 0;
+}
+
+void AnalysisCheckpoint::SetNumGamesDone(const string & pgnfile, size_t num_games) {
+  games_done_[pgnfile] = num_games;
+}
+
+}
+}
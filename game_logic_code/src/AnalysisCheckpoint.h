@@ -0,0 +1,51 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef ANALYSISCHECKPOINT_H_
+#define ANALYSISCHECKPOINT_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace acortes {
+namespace chess {
+
+// Progress of a batch analysis: the games of each PGN file whose records
+// are in the output, and the size of the output at that point. Games are
+// written in order, so a run can be resumed by skipping those games and
+// cutting the output to that size, which drops the records of games
+// written after the checkpoint.
+// The file is replaced as a whole when saved, so a run interrupted while
+// saving still finds the previous checkpoint. The output has to be on
+// disk before a checkpoint that counts it is saved, see SyncFile().
+class AnalysisCheckpoint {
+public:
+  explicit AnalysisCheckpoint(const std::string & filename);
+  // false if there is no checkpoint or it cannot be read, then nothing
+  // is done
+  bool Load();
+  // the checkpoint is on disk when it returns true
+  bool Save() const;
+
+  size_t GetNumGamesDone(const std::string & pgnfile) const;
+  void SetNumGamesDone(const std::string & pgnfile, size_t num_games);
+  uint64_t GetOutputSize() const { return output_size_; }
+  void SetOutputSize(uint64_t output_size) { output_size_ = output_size; }
+
+  // writes what the system keeps of a file to disk, false if it fails
+  static bool SyncFile(const std::string & path);
+
+private:
+  std::string filename_;
+  std::map<std::string, size_t> games_done_;
+  uint64_t output_size_;
+};
+
+}
+}
+
+#endif /* ANALYSISCHECKPOINT_H_ */
@@ -0,0 +1,145 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <cstdio>
+#include "AnalysisWriter.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+// centipawns lost by the side that moved
+long GetLoss(const MoveAnalysis & move) {
+  long diff = move.best.score - move.played.score;
+  return (move.ply % 2 == 0) ? diff : -diff;
+}
+
+}
+
+const size_t AnalysisWriter::BUFFER_SIZE;
+
+AnalysisWriter::AnalysisWriter(ostream & output, Format format, bool blunders_only) :
+  output_(output), format_(format), blunders_only_(blunders_only),
+  has_header_(format != Format::CSV) {
+  buffer_.reserve(BUFFER_SIZE);
+}
+
+AnalysisWriter::~AnalysisWriter() {
+  Flush();
+}
+
+bool AnalysisWriter::GetFormat(const string & name, Format & format) {
+  if(name == "csv") {
+    format = Format::CSV;
+  } else if(name == "ndjson") {
+    format = Format::NDJSON;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+size_t AnalysisWriter::Write(const AnalyzedGame & game, const GameAnalysis & analysis) {
+  if(!has_header_) {
+    buffer_ += "file,game,white,black,ply,side,move,best_move,pre_score,pre_mate,"
+               "post_score,post_mate,loss,depth,blunder,pv\n";
+    has_header_ = true;
+  }
+
+  size_t num_records = 0;
+  for(const auto & move : analysis.moves) {
+    // moves the engine failed to analyze are left out
+    if((blunders_only_ && !move.is_blunder) || !move.best.is_valid ||
+       !move.played.is_valid) {
+      continue;
+    }
+    if(format_ == Format::CSV) {
+      WriteCSV(game, move);
+    } else {
+      WriteNDJSON(game, move);
+    }
+    num_records++;
+  }
+
+  if(buffer_.size() >= BUFFER_SIZE) {
+    Flush();
+  }
+  return num_records;
+}
+
+void AnalysisWriter::Flush() {
+  output_.write(buffer_.data(), buffer_.size());
+  output_.flush();
+  buffer_.clear();
+}
+
+void AnalysisWriter::WriteCSV(const AnalyzedGame & game, const MoveAnalysis & move) {
+  buffer_ += CSVField(game.file) + "," + to_string(game.index + 1) + "," +
+             CSVField(game.white) + "," + CSVField(game.black) + "," +
+             to_string(move.ply + 1) + "," + ((move.ply % 2 == 0) ? "w" : "b") + "," +
+             move.move + "," + move.best.best + "," +
+             to_string(move.best.score) + "," + to_string(move.best.mate) + "," +
+             to_string(move.played.score) + "," + to_string(move.played.mate) + "," +
+             to_string(GetLoss(move)) + "," + to_string(move.best.depth) + "," +
+             (move.is_blunder ? "1" : "0") + "," + move.best.line + "\n";
+}
+
+void AnalysisWriter::WriteNDJSON(const AnalyzedGame & game, const MoveAnalysis & move) {
+  buffer_ += "{\"file\":" + JSONString(game.file) +
+             ",\"game\":" + to_string(game.index + 1) +
+             ",\"white\":" + JSONString(game.white) +
+             ",\"black\":" + JSONString(game.black) +
+             ",\"ply\":" + to_string(move.ply + 1) +
+             ",\"side\":" + ((move.ply % 2 == 0) ? "\"w\"" : "\"b\"") +
+             ",\"move\":" + JSONString(move.move) +
+             ",\"best_move\":" + JSONString(move.best.best) +
+             ",\"pre_score\":" + to_string(move.best.score) +
+             ",\"pre_mate\":" + to_string(move.best.mate) +
+             ",\"post_score\":" + to_string(move.played.score) +
+             ",\"post_mate\":" + to_string(move.played.mate) +
+             ",\"loss\":" + to_string(GetLoss(move)) +
+             ",\"depth\":" + to_string(move.best.depth) +
+             ",\"blunder\":" + (move.is_blunder ? "true" : "false") +
+             ",\"pv\":" + JSONString(move.best.line) + "}\n";
+}
+
+// quotes a field when needed, names are written as "Last, First"
+string AnalysisWriter::CSVField(const string & field) {
+  if(field.find_first_of(",\"\n") == string::npos) {
+    return field;
+  }
+  string quoted = "\"";
+  for(char c : field) {
+    if(c == '"') {
+      quoted += '"';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+string AnalysisWriter::JSONString(const string & text) {
+  string quoted = "\"";
+  for(char c : text) {
+    if(c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if(static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+}
+}
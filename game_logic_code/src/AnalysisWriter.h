@@ -0,0 +1,64 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef ANALYSISWRITER_H_
+#define ANALYSISWRITER_H_
+
+#include <ostream>
+#include <string>
+#include "ChessEngineInterface.h"
+
+namespace acortes {
+namespace chess {
+
+// game an analysis belongs to, written in every record
+struct AnalyzedGame {
+  std::string file;
+  // position of the game in the file, starting at 0
+  size_t index;
+  std::string white;
+  std::string black;
+};
+
+// Writes game analyses as one record per analyzed move, or per blunder,
+// in CSV with a header line or in NDJSON, one object per line. Records
+// are kept in a buffer and written in large pieces, so the output can go
+// to a pipe without a write for every line.
+class AnalysisWriter {
+public:
+  enum class Format { CSV, NDJSON };
+
+  static const size_t BUFFER_SIZE = 64 * 1024;
+
+  AnalysisWriter(std::ostream & output, Format format, bool blunders_only = false);
+  ~AnalysisWriter();
+  // returns the number of records written
+  size_t Write(const AnalyzedGame & game, const GameAnalysis & analysis);
+  void Flush();
+  // when appending to an output that already has the header
+  void SkipHeader() { has_header_ = true; }
+
+  // "csv" or "ndjson", false for anything else
+  static bool GetFormat(const std::string & name, Format & format);
+  // quotes a CSV field when needed
+  static std::string CSVField(const std::string & field);
+
+private:
+  std::ostream & output_;
+  Format format_;
+  bool blunders_only_;
+  bool has_header_;
+  std::string buffer_;
+
+  void WriteCSV(const AnalyzedGame & game, const MoveAnalysis & move);
+  void WriteNDJSON(const AnalyzedGame & game, const MoveAnalysis & move);
+  static std::string JSONString(const std::string & text);
+};
+
+}
+}
+
+#endif /* ANALYSISWRITER_H_ */
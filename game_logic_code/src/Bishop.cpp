@@ -5,6 +5,7 @@
  */
 
 #include "Bishop.h"
+#include "Board.h"
 #include <cassert>
 
 namespace acortes {
@@ -12,7 +13,7 @@ namespace chess {
 
 const std::string Bishop::LongName = "Bishop";
 
-Bishop::Bishop(Player * player) : Piece(player) {
+Bishop::Bishop(Player * player) : Piece(player, PieceType::Bishop) {
 
 }
 
@@ -42,7 +43,8 @@ bool Bishop::IsValidMove(int new_file, int new_rank) const {
     return false;
   } else if(file_movement == rank_movement) {
     // diagonal movement
-    return true;
+    // check no pieces in between
+    return board_->IsPathClear(file_, rank_, new_file, new_rank);
   }
   return false;
 }
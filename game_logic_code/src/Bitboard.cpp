@@ -0,0 +1,89 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <cstdlib>
+#include "Bitboard.h"
+
+namespace acortes {
+namespace chess {
+
+Bitboard between_table[NUM_SQUARES][NUM_SQUARES];
+Bitboard line_table[NUM_SQUARES][NUM_SQUARES];
+Bitboard ray_table[NUM_DIRECTIONS][NUM_SQUARES];
+Bitboard knight_attacks_table[NUM_SQUARES];
+Bitboard king_attacks_table[NUM_SQUARES];
+Bitboard pawn_attacks_table[NUM_COLORS][NUM_SQUARES];
+
+namespace {
+
+const int direction_file_step[NUM_DIRECTIONS] = { 0, 1, 1, -1, 0, -1, -1, 1 };
+const int direction_rank_step[NUM_DIRECTIONS] = { 1, 0, 1, 1, -1, 0, -1, -1 };
+
+// the square at the given offset, or 0 if it falls outside of the board
+Bitboard OffsetBB(int square, int file_offset, int rank_offset) {
+  int file = SquareFile(square) + file_offset;
+  int rank = SquareRank(square) + rank_offset;
+  if(file < 0 || file > 7 || rank < 0 || rank > 7) {
+    return 0;
+  }
+  return SquareBB(GetSquare(file, rank));
+}
+
+struct BitboardTables {
+  BitboardTables() {
+    for(int square = 0; square < NUM_SQUARES; ++square) {
+      for(int d = 0; d < NUM_DIRECTIONS; ++d) {
+        ray_table[d][square] = 0;
+        for(int i = 1; i < 8; ++i) {
+          Bitboard bb = OffsetBB(square, i * direction_file_step[d],
+              i * direction_rank_step[d]);
+          if(bb == 0) break;
+          ray_table[d][square] |= bb;
+        }
+      }
+
+      knight_attacks_table[square] =
+          OffsetBB(square, 1, 2) | OffsetBB(square, 2, 1) |
+          OffsetBB(square, 2, -1) | OffsetBB(square, 1, -2) |
+          OffsetBB(square, -1, -2) | OffsetBB(square, -2, -1) |
+          OffsetBB(square, -2, 1) | OffsetBB(square, -1, 2);
+
+      king_attacks_table[square] = 0;
+      for(int d = 0; d < NUM_DIRECTIONS; ++d) {
+        king_attacks_table[square] |= OffsetBB(square,
+            direction_file_step[d], direction_rank_step[d]);
+      }
+
+      pawn_attacks_table[ToIndex(Color::Light)][square] =
+          OffsetBB(square, -1, 1) | OffsetBB(square, 1, 1);
+      pawn_attacks_table[ToIndex(Color::Dark)][square] =
+          OffsetBB(square, -1, -1) | OffsetBB(square, 1, -1);
+    }
+
+    for(int from = 0; from < NUM_SQUARES; ++from) {
+      for(int to = 0; to < NUM_SQUARES; ++to) {
+        between_table[from][to] = 0;
+        line_table[from][to] = 0;
+      }
+      for(int d = 0; d < NUM_DIRECTIONS; ++d) {
+        // the opposite direction is always four positions away
+        int opposite = (d + 4) % NUM_DIRECTIONS;
+        Bitboard ray = ray_table[d][from];
+        while(ray) {
+          int to = PopLSB(ray);
+          between_table[from][to] = ray_table[d][from] & ray_table[opposite][to];
+          line_table[from][to] = ray_table[d][from] | ray_table[opposite][from] |
+              SquareBB(from);
+        }
+      }
+    }
+  }
+} tables_;
+
+}
+
+}
+}
@@ -0,0 +1,138 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef BITBOARD_H_
+#define BITBOARD_H_
+
+#include <cstdint>
+#include "Common.h"
+
+namespace acortes {
+namespace chess {
+
+// one bit per square, bit 0 is a1, bit 7 is h1 and bit 63 is h8
+typedef uint64_t Bitboard;
+
+const int NUM_SQUARES = 64;
+
+inline int GetSquare(int file, int rank) {
+  return (rank << 3) | file;
+}
+
+inline int SquareFile(int square) {
+  return square & 7;
+}
+
+inline int SquareRank(int square) {
+  return square >> 3;
+}
+
+inline Bitboard SquareBB(int square) {
+  return static_cast<Bitboard>(1) << square;
+}
+
+inline int PopCount(Bitboard b) {
+  return __builtin_popcountll(b);
+}
+
+// index of the least significant bit, b shall not be empty
+inline int LSB(Bitboard b) {
+  return __builtin_ctzll(b);
+}
+
+// index of the most significant bit, b shall not be empty
+inline int MSB(Bitboard b) {
+  return 63 - __builtin_clzll(b);
+}
+
+// removes the least significant bit and returns its index
+inline int PopLSB(Bitboard & b) {
+  int square = LSB(b);
+  b &= b - 1;
+  return square;
+}
+
+// sliding directions, the first four go towards higher squares
+enum Direction {
+  NORTH,
+  EAST,
+  NORTH_EAST,
+  NORTH_WEST,
+  SOUTH,
+  WEST,
+  SOUTH_WEST,
+  SOUTH_EAST,
+  NUM_DIRECTIONS
+};
+
+// precomputed tables, filled in Bitboard.cpp before main() is called
+extern Bitboard between_table[NUM_SQUARES][NUM_SQUARES];
+extern Bitboard line_table[NUM_SQUARES][NUM_SQUARES];
+extern Bitboard ray_table[NUM_DIRECTIONS][NUM_SQUARES];
+extern Bitboard knight_attacks_table[NUM_SQUARES];
+extern Bitboard king_attacks_table[NUM_SQUARES];
+extern Bitboard pawn_attacks_table[NUM_COLORS][NUM_SQUARES];
+
+// squares strictly between two squares on the same rank, file or
+// diagonal. Empty if the squares are not aligned.
+inline Bitboard Between(int from, int to) {
+  return between_table[from][to];
+}
+
+// whole rank, file or diagonal going through both squares, including
+// them. Empty if the squares are not aligned.
+inline Bitboard Line(int from, int to) {
+  return line_table[from][to];
+}
+
+inline Bitboard KnightAttacks(int square) {
+  return knight_attacks_table[square];
+}
+
+inline Bitboard KingAttacks(int square) {
+  return king_attacks_table[square];
+}
+
+// squares attacked by a pawn of the given color
+inline Bitboard PawnAttacks(Color color, int square) {
+  return pawn_attacks_table[ToIndex(color)][square];
+}
+
+// attacks along a ray stop at the first occupied square, which is
+// included in the attack set
+template<Direction direction>
+inline Bitboard RayAttacks(int square, Bitboard occupancy) {
+  Bitboard attacks = ray_table[direction][square];
+  Bitboard blockers = attacks & occupancy;
+  if(blockers) {
+    int blocker = (direction < SOUTH) ? LSB(blockers) : MSB(blockers);
+    attacks ^= ray_table[direction][blocker];
+  }
+  return attacks;
+}
+
+inline Bitboard RookAttacks(int square, Bitboard occupancy) {
+  return RayAttacks<NORTH>(square, occupancy) |
+         RayAttacks<EAST>(square, occupancy) |
+         RayAttacks<SOUTH>(square, occupancy) |
+         RayAttacks<WEST>(square, occupancy);
+}
+
+inline Bitboard BishopAttacks(int square, Bitboard occupancy) {
+  return RayAttacks<NORTH_EAST>(square, occupancy) |
+         RayAttacks<NORTH_WEST>(square, occupancy) |
+         RayAttacks<SOUTH_EAST>(square, occupancy) |
+         RayAttacks<SOUTH_WEST>(square, occupancy);
+}
+
+inline Bitboard QueenAttacks(int square, Bitboard occupancy) {
+  return RookAttacks(square, occupancy) | BishopAttacks(square, occupancy);
+}
+
+}
+}
+
+#endif /* BITBOARD_H_ */
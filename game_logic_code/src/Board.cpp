@@ -5,21 +5,56 @@
  *  See LICENSE file in the root of this project
  */
 #include <cassert>
+#include <cctype>
 #include "Board.h"
 #include "Piece.h"
+#include "Zobrist.h"
 using namespace std;
 
 namespace acortes {
 namespace chess {
 
-// initialize board to contain num_files_*num_ranks_ pointers
-// to pieces
+namespace {
+
+// castling rights kept after a move from or to each square, moving the
+// king or a rook, or capturing a rook, loses the related rights
+struct CastlingMasks {
+  int masks[NUM_SQUARES];
+  CastlingMasks() {
+    for(auto & mask : masks) {
+      mask = ALL_CASTLING;
+    }
+    masks[GetSquare(0, 0)] &= ~LIGHT_LONG_CASTLE;
+    masks[GetSquare(7, 0)] &= ~LIGHT_SHORT_CASTLE;
+    masks[GetSquare(4, 0)] &= ~(LIGHT_SHORT_CASTLE | LIGHT_LONG_CASTLE);
+    masks[GetSquare(0, 7)] &= ~DARK_LONG_CASTLE;
+    masks[GetSquare(7, 7)] &= ~DARK_SHORT_CASTLE;
+    masks[GetSquare(4, 7)] &= ~(DARK_SHORT_CASTLE | DARK_LONG_CASTLE);
+  }
+} castling_masks_;
+
+}
+
+// initialize an empty board, positions are kept in 64 bit sets so
+// at most 8 files and 8 ranks are supported
 Board::Board(int num_files, int num_ranks) :
     num_files_(num_files), num_ranks_(num_ranks),
-    en_passant_candidate_(nullptr) {
-  board_.resize(num_ranks_);
-  for(auto & files : board_) {
-    files.resize(num_files_);
+    occupied_(0),
+    side_to_move_(Color::Light),
+    castling_rights_(NO_CASTLING),
+    en_passant_square_(-1),
+    en_passant_candidate_(nullptr),
+    key_(0) {
+  assert(num_files_ > 0 && num_files_ <= 8);
+  assert(num_ranks_ > 0 && num_ranks_ <= 8);
+  for(auto & pieces : pieces_) {
+    pieces = 0;
+  }
+  for(auto & colors : colors_) {
+    colors = 0;
+  }
+  for(auto & square : squares_) {
+    square = nullptr;
   }
 }
 
@@ -29,35 +64,398 @@ void Board::PutPiece(Piece * piece, int file, int rank) {
   assert(file >= 0 && file < num_files_);
   assert(rank >= 0 && rank < num_ranks_);
 
-  board_[rank][file] = piece;
+  int square = GetSquare(file, rank);
+  assert(squares_[square] == nullptr);
+
+  squares_[square] = piece;
+  SetSquare(square, piece->GetType(), piece->GetColor());
 }
 
 Piece * Board::RemovePiece(int file, int rank) {
-  assert (board_[rank][file] != nullptr);
+  int square = GetSquare(file, rank);
+  Piece * piece = squares_[square];
+  assert(piece != nullptr);
 
-  Piece * piece = board_[rank][file];
-  board_[rank][file] = nullptr;
+  squares_[square] = nullptr;
+  ClearSquare(square);
 
   return piece;
 }
 
-Piece * Board::GetPiece(int file, int rank) {
-  return board_[rank][file];
+// swap the object in an occupied square for another one of the same
+// kind, the previous one is taken off the board and returned. Used
+// when a pawn is promoted and taken back.
+Piece * Board::ReplacePiece(int square, Piece * piece) {
+  assert(piece != nullptr);
+  assert(!IsEmpty(SquareFile(square), SquareRank(square)));
+
+  Piece * previous = squares_[square];
+  if(previous != nullptr) {
+    previous->Captured();
+  }
+  squares_[square] = piece;
+  piece->board_ = this;
+  piece->file_ = SquareFile(square);
+  piece->rank_ = SquareRank(square);
+
+  return previous;
+}
+
+// put a piece of the given type in an empty square, only the
+// bitboards are updated
+void Board::SetSquare(int square, PieceType type, Color color) {
+  Bitboard bb = SquareBB(square);
+  assert((occupied_ & bb) == 0);
+
+  pieces_[ToIndex(type)] |= bb;
+  colors_[ToIndex(color)] |= bb;
+  occupied_ |= bb;
+  key_ ^= Zobrist::Piece(color, type, square);
+}
+
+void Board::ClearSquare(int square) {
+  PieceType type = GetPieceType(square);
+  if(type == PieceType::None) {
+    return;
+  }
+
+  Bitboard bb = SquareBB(square);
+  Color color = (colors_[ToIndex(Color::Light)] & bb) ? Color::Light : Color::Dark;
+  pieces_[ToIndex(type)] ^= bb;
+  colors_[ToIndex(color)] ^= bb;
+  occupied_ ^= bb;
+  key_ ^= Zobrist::Piece(color, type, square);
+}
+
+void Board::SetSideToMove(Color color) {
+  if(color != side_to_move_) {
+    key_ ^= Zobrist::dark_to_move;
+  }
+  side_to_move_ = color;
+}
+
+void Board::SetCastlingRights(int castling_rights) {
+  key_ ^= Zobrist::castling[castling_rights_] ^ Zobrist::castling[castling_rights];
+  castling_rights_ = castling_rights;
+}
+
+void Board::UpdateCastlingRights(int from, int to) {
+  SetCastlingRights(castling_rights_ &
+      castling_masks_.masks[from] & castling_masks_.masks[to]);
+}
+
+void Board::SetEnPassantCandidate(Piece * piece) {
+  if(piece != nullptr) {
+    // the target square is the one the pawn jumped over
+    int rank = piece->GetRank() + ((piece->GetColor() == Color::Light) ? -1 : 1);
+    SetEnPassantSquare(GetSquare(piece->GetFile(), rank));
+  } else {
+    SetEnPassantSquare(-1);
+  }
+  en_passant_candidate_ = piece;
+}
+
+void Board::SetEnPassantSquare(int square) {
+  en_passant_candidate_ = nullptr;
+  en_passant_square_ = square;
+}
+
+// key of the position computed from scratch, it shall always be equal
+// to the incrementally updated one
+uint64_t Board::ComputeKey() const {
+  uint64_t key = 0;
+  for(int color = 0; color < NUM_COLORS; ++color) {
+    for(int type = 0; type < NUM_PIECE_TYPES; ++type) {
+      Bitboard pieces = pieces_[type] & colors_[color];
+      while(pieces) {
+        key ^= Zobrist::Piece(static_cast<Color>(color),
+            static_cast<PieceType>(type), PopLSB(pieces));
+      }
+    }
+  }
+  key ^= Zobrist::castling[castling_rights_];
+  key ^= GetEnPassantKey();
+  if(side_to_move_ == Color::Dark) {
+    key ^= Zobrist::dark_to_move;
+  }
+  return key;
+}
+
+// move a piece between two squares, the destination shall be empty.
+// Piece objects follow the move.
+void Board::MovePiece(int from, int to, PieceType type, Color color) {
+  Bitboard from_to = SquareBB(from) | SquareBB(to);
+  pieces_[ToIndex(type)] ^= from_to;
+  colors_[ToIndex(color)] ^= from_to;
+  occupied_ ^= from_to;
+  key_ ^= Zobrist::Piece(color, type, from) ^ Zobrist::Piece(color, type, to);
+
+  Piece * piece = squares_[from];
+  squares_[to] = piece;
+  squares_[from] = nullptr;
+  if(piece != nullptr) {
+    piece->file_ = SquareFile(to);
+    piece->rank_ = SquareRank(to);
+  }
+}
+
+// play a legal move for the side to move. When the board holds Piece
+// objects they are kept in their squares, a promoted pawn keeps its
+// object until the owner replaces it.
+void Board::MakeMove(PackedMove move, MoveUndo & undo) {
+  const int from = move.GetFrom();
+  const int to = move.GetTo();
+  const Color us = side_to_move_;
+  const PieceType type = GetPieceType(from);
+
+  undo.captured = PieceType::None;
+  undo.captured_piece = nullptr;
+  undo.castling_rights = castling_rights_;
+  undo.en_passant_square = en_passant_square_;
+  undo.en_passant_candidate = en_passant_candidate_;
+  undo.key = key_;
+
+  if(move.IsCapture()) {
+    int captured_square = to;
+    if(move.IsEnPassant()) {
+      captured_square = (us == Color::Light) ? to - 8 : to + 8;
+    }
+    Piece * captured_piece = squares_[captured_square];
+    undo.captured = GetPieceType(captured_square);
+    undo.captured_piece = captured_piece;
+    ClearSquare(captured_square);
+    squares_[captured_square] = nullptr;
+    if(captured_piece != nullptr) {
+      captured_piece->Captured();
+    }
+  }
+
+  MovePiece(from, to, type, us);
+  Piece * piece = squares_[to];
+  if(piece != nullptr) {
+    piece->num_moves_++;
+  }
+
+  if(move.IsPromotion()) {
+    Bitboard bb = SquareBB(to);
+    pieces_[ToIndex(PieceType::Pawn)] ^= bb;
+    pieces_[ToIndex(move.GetPromotion())] |= bb;
+    key_ ^= Zobrist::Piece(us, PieceType::Pawn, to) ^
+        Zobrist::Piece(us, move.GetPromotion(), to);
+  } else if(move.IsCastle()) {
+    int rank = SquareRank(from);
+    bool short_castle = move.GetFlags() == PackedMove::SHORT_CASTLE;
+    int rook_from = GetSquare(short_castle ? 7 : 0, rank);
+    int rook_to = GetSquare(short_castle ? 5 : 3, rank);
+    MovePiece(rook_from, rook_to, PieceType::Rook, us);
+    if(squares_[rook_to] != nullptr) {
+      squares_[rook_to]->num_moves_++;
+    }
+  }
+
+  if(move.GetFlags() == PackedMove::DOUBLE_PAWN_PUSH) {
+    en_passant_square_ = (from + to) / 2;
+    en_passant_candidate_ = piece;
+  } else {
+    en_passant_square_ = -1;
+    en_passant_candidate_ = nullptr;
+  }
+
+  UpdateCastlingRights(from, to);
+  side_to_move_ = Opponent(us);
+  key_ ^= Zobrist::dark_to_move;
+}
+
+// take back the last move made with MakeMove
+void Board::UnmakeMove(PackedMove move, const MoveUndo & undo) {
+  const int from = move.GetFrom();
+  const int to = move.GetTo();
+  const Color us = Opponent(side_to_move_);
+
+  side_to_move_ = us;
+  castling_rights_ = undo.castling_rights;
+  en_passant_square_ = undo.en_passant_square;
+  en_passant_candidate_ = undo.en_passant_candidate;
+
+  if(move.IsPromotion()) {
+    Bitboard bb = SquareBB(to);
+    pieces_[ToIndex(move.GetPromotion())] ^= bb;
+    pieces_[ToIndex(PieceType::Pawn)] |= bb;
+  } else if(move.IsCastle()) {
+    int rank = SquareRank(from);
+    bool short_castle = move.GetFlags() == PackedMove::SHORT_CASTLE;
+    int rook_from = GetSquare(short_castle ? 7 : 0, rank);
+    int rook_to = GetSquare(short_castle ? 5 : 3, rank);
+    MovePiece(rook_to, rook_from, PieceType::Rook, us);
+    if(squares_[rook_from] != nullptr) {
+      squares_[rook_from]->num_moves_--;
+    }
+  }
+
+  MovePiece(to, from, GetPieceType(to), us);
+  if(squares_[from] != nullptr) {
+    squares_[from]->num_moves_--;
+  }
+
+  if(undo.captured != PieceType::None) {
+    int captured_square = to;
+    if(move.IsEnPassant()) {
+      captured_square = (us == Color::Light) ? to - 8 : to + 8;
+    }
+    SetSquare(captured_square, undo.captured, Opponent(us));
+    squares_[captured_square] = undo.captured_piece;
+    if(undo.captured_piece != nullptr) {
+      undo.captured_piece->board_ = this;
+      undo.captured_piece->file_ = SquareFile(captured_square);
+      undo.captured_piece->rank_ = SquareRank(captured_square);
+    }
+  }
+
+  // the pieces moved back changed the key, the saved one is exact
+  key_ = undo.key;
+}
+
+// forget the Piece objects, the position is kept in the bitboards.
+// Used on copies of a board that are searched on their own.
+void Board::DetachPieces() {
+  for(auto & square : squares_) {
+    square = nullptr;
+  }
+  en_passant_candidate_ = nullptr;
+}
+
+bool Board::IsEmpty(int file, int rank) const {
+  return (occupied_ & SquareBB(GetSquare(file, rank))) == 0;
+}
+
+// true if there are no pieces between both squares, the squares
+// themselves are not checked
+bool Board::IsPathClear(int from_file, int from_rank,
+    int to_file, int to_rank) const {
+  return (Between(GetSquare(from_file, from_rank),
+                  GetSquare(to_file, to_rank)) & occupied_) == 0;
+}
+
+PieceType Board::GetPieceType(int square) const {
+  Bitboard bb = SquareBB(square);
+  if(occupied_ & bb) {
+    for(int type = 0; type < NUM_PIECE_TYPES; ++type) {
+      if(pieces_[type] & bb) {
+        return static_cast<PieceType>(type);
+      }
+    }
+  }
+  return PieceType::None;
+}
+
+// FEN letter of the piece in the square, upper case for light pieces
+char Board::GetFENChar(int square) const {
+  static const char names[] = "pnbrqk";
+  char c = names[ToIndex(GetPieceType(square))];
+  if(colors_[ToIndex(Color::Light)] & SquareBB(square)) {
+    c = toupper(c);
+  }
+  return c;
+}
+
+// set up the position described by the first four fields of a FEN
+// string (placement, side to move, castling and en passant). The board
+// is emptied first and no Piece objects are created.
+bool Board::LoadFEN(const std::string & fen) {
+  static const string names = "pnbrqk";
+  size_t i = 0;
+  int file = 0;
+  int rank = num_ranks_ - 1;
+
+  for(auto & pieces : pieces_) {
+    pieces = 0;
+  }
+  colors_[0] = colors_[1] = occupied_ = 0;
+  for(auto & square : squares_) {
+    square = nullptr;
+  }
+  en_passant_candidate_ = nullptr;
+  en_passant_square_ = -1;
+  castling_rights_ = NO_CASTLING;
+  side_to_move_ = Color::Light;
+  key_ = 0;
+
+  // piece placement
+  for(; i < fen.size() && fen[i] != ' '; ++i) {
+    char c = fen[i];
+    if(c == '/') {
+      if(file != num_files_ || rank == 0) return false;
+      file = 0;
+      rank--;
+    } else if(c >= '1' && c <= '8') {
+      file += c - '0';
+      if(file > num_files_) return false;
+    } else {
+      size_t type = names.find(tolower(c));
+      if(type == string::npos || file >= num_files_) return false;
+      SetSquare(GetSquare(file, rank), static_cast<PieceType>(type),
+          isupper(c) ? Color::Light : Color::Dark);
+      file++;
+    }
+  }
+  if(file != num_files_ || rank != 0) return false;
+  if(PopCount(GetPieces(PieceType::King, Color::Light)) != 1 ||
+     PopCount(GetPieces(PieceType::King, Color::Dark)) != 1) {
+    return false;
+  }
+
+  // side to move
+  if(++i >= fen.size()) return false;
+  if(fen[i] == 'b') {
+    side_to_move_ = Color::Dark;
+  } else if(fen[i] != 'w') {
+    return false;
+  }
+  i++;
+
+  // castling availability, missing fields are allowed from here on
+  for(i++; i < fen.size() && fen[i] != ' '; ++i) {
+    switch(fen[i]) {
+      case 'K': castling_rights_ |= LIGHT_SHORT_CASTLE; break;
+      case 'Q': castling_rights_ |= LIGHT_LONG_CASTLE; break;
+      case 'k': castling_rights_ |= DARK_SHORT_CASTLE; break;
+      case 'q': castling_rights_ |= DARK_LONG_CASTLE; break;
+      case '-': break;
+      default: return false;
+    }
+  }
+
+  // en passant target square
+  if(++i < fen.size() && fen[i] != '-') {
+    if(i + 1 >= fen.size()) return false;
+    int ep_file = chess::GetFile(fen[i]);
+    int ep_rank = chess::GetRank(fen[i+1]);
+    if(ep_file < 0 || ep_file >= num_files_ ||
+       ep_rank < 0 || ep_rank >= num_ranks_) {
+      return false;
+    }
+    en_passant_square_ = GetSquare(ep_file, ep_rank);
+  }
+
+  // the en passant square is added by GetKey()
+  key_ = ComputeKey() ^ GetEnPassantKey();
+  return true;
 }
 
 string Board::FEN() const {
   int empty_spaces = 0;
   std::string fen;
-  for(auto rank = board_.rbegin(); rank != board_.rend(); ++rank) {
-    for(auto cell = (*rank).begin(); cell != (*rank).end(); ++cell) {
-      if(*cell == nullptr) {
+  for(int rank = num_ranks_ - 1; rank >= 0; --rank) {
+    for(int file = 0; file < num_files_; ++file) {
+      int square = GetSquare(file, rank);
+      if((occupied_ & SquareBB(square)) == 0) {
         ++empty_spaces;
       } else {
         if(empty_spaces) {
           fen.append(std::to_string(empty_spaces));
           empty_spaces = 0;
         }
-        fen.append((*cell)->FEN());
+        fen.append(1, GetFENChar(square));
       }
     } // end of a rank
 
@@ -75,10 +473,11 @@ void Board::Print(char (* printed_board)[64]) const {
   char * c = *printed_board;
   char space = '.';
 
-  for(auto rank = board_.rbegin(); rank != board_.rend(); ++rank) {
-    for(auto cell = rank->begin(); cell != rank->end(); ++cell) {
-      if(*cell) {
-        *c = ((*cell)->FEN()).c_str()[0];
+  for(int rank = num_ranks_ - 1; rank >= 0; --rank) {
+    for(int file = 0; file < num_files_; ++file) {
+      int square = GetSquare(file, rank);
+      if(occupied_ & SquareBB(square)) {
+        *c = GetFENChar(square);
       } else {
         *c = space;
       }
@@ -7,33 +7,99 @@
 #ifndef BOARD_H_
 #define BOARD_H_
 
-#include <vector>
 #include "Common.h"
+#include "Bitboard.h"
+#include "PackedMove.h"
+#include "Zobrist.h"
 
 namespace acortes {
 namespace chess {
 
 class Piece;
 
+// FEN of the initial position
+const char START_FEN[] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// state needed to take back a move made with Board::MakeMove
+struct MoveUndo {
+  PieceType captured;
+  Piece * captured_piece;
+  int castling_rights;
+  int en_passant_square;
+  Piece * en_passant_candidate;
+  uint64_t key;
+};
+
 class Board {
 public:
   Board(int num_files, int num_ranks);
   void PutPiece(Piece * piece, int file, int rank);
   Piece * RemovePiece(int file, int rank);
-  Piece * GetPiece(int file, int rank);
+  Piece * GetPiece(int file, int rank) const { return squares_[GetSquare(file, rank)]; }
+  Piece * ReplacePiece(int square, Piece * piece);
+  void SetSquare(int square, PieceType type, Color color);
+  void ClearSquare(int square);
+  bool IsEmpty(int file, int rank) const;
+  bool IsPathClear(int from_file, int from_rank, int to_file, int to_rank) const;
+  PieceType GetPieceType(int square) const;
+  Bitboard GetPieces(PieceType type, Color color) const {
+    return pieces_[ToIndex(type)] & colors_[ToIndex(color)];
+  }
+  Bitboard GetPieces(PieceType type) const { return pieces_[ToIndex(type)]; }
+  Bitboard GetPieces(Color color) const { return colors_[ToIndex(color)]; }
+  Bitboard GetOccupancy() const { return occupied_; }
+  int GetKingSquare(Color color) const {
+    return LSB(GetPieces(PieceType::King, color));
+  }
+  bool LoadFEN(const std::string & fen);
   std::string FEN() const;
   int GetNumFiles() { return num_files_; }
   int GetNumRanks() { return num_ranks_; }
+  Color GetSideToMove() const { return side_to_move_; }
+  void SetSideToMove(Color color);
+  int GetCastlingRights() const { return castling_rights_; }
+  void SetCastlingRights(int castling_rights);
+  void UpdateCastlingRights(int from, int to);
   Piece * GetEnPassantCandidate() const { return en_passant_candidate_; }
-  void SetEnPassantCandidate(Piece * piece) { en_passant_candidate_ = piece; }
+  void SetEnPassantCandidate(Piece * piece);
+  int GetEnPassantSquare() const { return en_passant_square_; }
+  void SetEnPassantSquare(int square);
+  void MakeMove(PackedMove move, MoveUndo & undo);
+  void UnmakeMove(PackedMove move, const MoveUndo & undo);
+  void DetachPieces();
+  // as in Polyglot, the en passant square is only part of the key when a
+  // pawn of the side to move can capture on it
+  uint64_t GetKey() const { return key_ ^ GetEnPassantKey(); }
+  uint64_t ComputeKey() const;
   void Print(char (* printed_board)[64]) const;
 
 protected:
   int num_files_;
   int num_ranks_;
-  std::vector<Piece *> pieces_;
-  std::vector<std::vector<Piece*> > board_;
+  // one set per piece kind and per color, plus the union of all of them
+  Bitboard pieces_[NUM_PIECE_TYPES];
+  Bitboard colors_[NUM_COLORS];
+  Bitboard occupied_;
+  // pieces indexed by square, see GetSquare(). Squares set through
+  // SetSquare() have no Piece object.
+  Piece * squares_[NUM_SQUARES];
+  Color side_to_move_;
+  int castling_rights_;
+  // square behind the pawn that just moved two squares, or -1
+  int en_passant_square_;
   Piece * en_passant_candidate_;
+  // Zobrist key of the position without the en passant square, updated
+  // with every change
+  uint64_t key_;
+
+  uint64_t GetEnPassantKey() const {
+    return (en_passant_square_ != -1 &&
+            (PawnAttacks(Opponent(side_to_move_), en_passant_square_) &
+             pieces_[ToIndex(PieceType::Pawn)] & colors_[ToIndex(side_to_move_)])) ?
+        Zobrist::EnPassant(en_passant_square_) : 0;
+  }
+  char GetFENChar(int square) const;
+  void MovePiece(int from, int to, PieceType type, Color color);
 };
 
 }
@@ -6,8 +6,17 @@
  */
 #include <sys/types.h>
 #include <sys/wait.h>
-#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
 #include "ChessEngineInterface.h"
+#include "Board.h"
+#include "MoveGenerator.h"
 
 using namespace std;
 
@@ -19,14 +28,41 @@ enum PIPE_FILE_DESC {
   WRITE_FD = 1
 };
 
-ChessEngineInterface::ChessEngineInterface(string engine_path, bool verbose) :
-  engine_path_(engine_path), verbose_(verbose) {
+namespace {
+
+// how much an info line is trusted as the result of the search: a line
+// of the variation with an exact score, then one with only a bound, as
+// sent when the search fails high or low, then one without a variation
+int GetRank(const UCIInfo & info) {
+  if(info.pv_length == 0) {
+    return 0;
+  }
+  return (info.bound == UCIInfo::Bound::Exact) ? 2 : 1;
+}
+
+}
+
+const int ChessEngineInterface::MAX_ATTEMPTS;
+const long ChessEngineInterface::STOP_TIMEOUT_MS;
+const long ChessEngineInterface::QUIT_TIMEOUT_MS;
+
+ChessEngineInterface::ChessEngineInterface(string engine_path, bool verbose,
+    const EngineOptions & options) :
+  engine_path_(engine_path), options_(options), pid_(-1), verbose_(verbose),
+  incremental_(false), new_game_(true), engine_id_(0), cache_(nullptr),
+  num_restarts_(0) {
   Initialize();
 }
 
-void ChessEngineInterface::Initialize() {
-  pipe(parentToChild_);
-  pipe(childToParent_);
+bool ChessEngineInterface::Initialize() {
+  if(pipe(parentToChild_) != 0) {
+    return false;
+  }
+  if(pipe(childToParent_) != 0) {
+    close(parentToChild_[READ_FD]);
+    close(parentToChild_[WRITE_FD]);
+    return false;
+  }
 
   // launch stockfish in another thread
   // setup pipes between parent and child
@@ -34,8 +70,12 @@ void ChessEngineInterface::Initialize() {
 
   switch(pid_ = fork()) {
     case -1:
-      // fork failed;
-      exit(-1);
+      // fork failed
+      for(int fd : {parentToChild_[READ_FD], parentToChild_[WRITE_FD],
+                    childToParent_[READ_FD], childToParent_[WRITE_FD]}) {
+        close(fd);
+      }
+      return false;
 
     case 0: // child launches stockfish
       close(parentToChild_[WRITE_FD]);
@@ -45,127 +85,211 @@ void ChessEngineInterface::Initialize() {
       dup2(childToParent_[WRITE_FD], STDERR_FILENO);
 
       execlp(engine_path_.c_str(), engine_path_.substr(index+1).c_str(), NULL);
-      exit(-1);
+      _exit(127);
 
     default: //parent
-      //cout << "Child " << pid_ << "running" << endl;
       close(parentToChild_[READ_FD]);
       close(childToParent_[WRITE_FD]);
+      reader_.SetFd(childToParent_[READ_FD]);
       break;
   }
 
   // initial handshaking
-  index_current_line_ = 0;
-  lines_.clear();
-
-  WaitForLine("Stockfish");
+  info_.Clear();
+  new_game_ = true;
+  auto deadline = GetDeadline(options_.start_timeout_ms);
+
+  // the engine may print something before, like its name, which is
+  // skipped until the answer to "uci"
+  engine_name_.clear();
+  engine_options_.clear();
   WriteLine("uci");
-  WaitForLine("uciok");
-  WriteLine("setoption name Hash value 32");
+  TextSpan line;
+  while(!line.StartsWith("uciok")) {
+    if(!GetNextLine(line, deadline)) {
+      Terminate();
+      return false;
+    }
+    if(line.StartsWith("id name ")) {
+      engine_name_ = line.ToString().substr(string("id name ").length());
+    } else if(line.StartsWith("option name ")) {
+      string option = line.ToString().substr(string("option name ").length());
+      engine_options_.push_back(option.substr(0, option.find(" type ")));
+    }
+  }
+  engine_id_ = AnalysisCache::GetEngineId(engine_name_);
+
+  SetOption("Hash", to_string(options_.hash_mb));
+  SetOption("Threads", to_string(options_.threads));
+  SetOption("MultiPV", to_string(options_.multipv));
+  if(!options_.syzygy_path.empty()) {
+    SetOption("SyzygyPath", options_.syzygy_path);
+  }
+  for(const auto & option : options_.custom) {
+    SetOption(option.first, option.second);
+  }
   WriteLine("isready");
-  WaitForLine("readyok");
+  if(!WaitForLine("readyok", line, deadline)) {
+    Terminate();
+    return false;
+  }
+  return true;
 }
 
 ChessEngineInterface::~ChessEngineInterface() {
-  int return_status;
-  WriteLine("quit");
-  waitpid(pid_, &return_status, 0);
+  Terminate();
 }
 
-size_t ChessEngineInterface::Read() {
-  struct timeval timeout;
-  timeout.tv_sec = 0;
-  timeout.tv_usec = 1000; //1 msec
-  size_t readResult = 0;
-
-  // setup for non-blocking reads from child
-  FD_ZERO(&readfds_);
-  FD_SET(childToParent_[READ_FD], &readfds_);
-
-  switch(select(1+childToParent_[READ_FD], & readfds_, (fd_set*)NULL, (fd_set*)NULL, &timeout)) {
-    case 0: // timeout
-      break;
-
-    case -1:
-      if(errno == EINTR || errno == EAGAIN) {
-        errno = 0;
-        break;
-      } else {
-        //cout << "select() failed" << endl;
-        exit(-1);
-      }
-
-    case 1:
-      readResult = read(childToParent_[READ_FD], buffer_, BUFFER_SIZE);
-      break;
+bool ChessEngineInterface::Restart() {
+  Terminate();
+  num_restarts_++;
+  return Initialize();
+}
 
-    default:
-      break;
+// the engine is asked to quit, and killed if it does not
+void ChessEngineInterface::Terminate() {
+  if(pid_ <= 0) {
+    return;
   }
-
-  return readResult;
+  WriteLine("quit");
+  int return_status = 0;
+  auto deadline = GetDeadline(QUIT_TIMEOUT_MS);
+  pid_t result;
+  while((result = waitpid(pid_, &return_status, WNOHANG)) == 0 &&
+        chrono::steady_clock::now() < deadline) {
+    this_thread::sleep_for(chrono::milliseconds(1));
+  }
+  if(result == 0) {
+    kill(pid_, SIGKILL);
+    waitpid(pid_, &return_status, 0);
+  }
+  if(verbose_ && WIFSIGNALED(return_status)) {
+    cerr << engine_path_ << " ended by signal " << WTERMSIG(return_status) << endl;
+  }
+  close(parentToChild_[WRITE_FD]);
+  close(childToParent_[READ_FD]);
+  reader_.SetFd(-1);
+  pid_ = -1;
 }
 
-void ChessEngineInterface::ReadLines(vector<string> & lines) {
-  while(size_t nbytes = Read()) {
-    char * start = buffer_;
-    char * current = buffer_;
-    char * end_buffer = buffer_ + nbytes;
-
-    while(current < end_buffer) {
-      if(*current == '\n') {
-        temp_string_.append(start, current);
-        lines.push_back(temp_string_);
-        //if (verbose_) {
-        //  cout << temp_string_ << endl;
-        //}
-        temp_string_.clear();
-        start = current + 1;
-      }
-      current++;
+bool ChessEngineInterface::HasOption(const string & name) const {
+  for(const auto & option : engine_options_) {
+    if(option == name) {
+      return true;
     }
-    temp_string_.append(start,current);
   }
+  return false;
 }
 
-std::string ChessEngineInterface::GetNextLine() {
-  std::string line = "";
-
-  if(lines_.size() == index_current_line_) {
-    // if lines have been processed, try to get more from
-    // the engine thread
-    ReadLines(lines_);
+void ChessEngineInterface::SetOption(const string & name, const string & value) {
+  if(HasOption(name)) {
+    WriteLine("setoption name " + name + " value " + value);
   }
+}
 
-  if(index_current_line_ < lines_.size()) {
-    line = lines_[index_current_line_];
-    index_current_line_++;
+// the line is only valid until the next one is read. False if the
+// engine closed its output or the deadline passed first.
+bool ChessEngineInterface::GetNextLine(TextSpan & line, Deadline deadline) {
+  while(!reader_.HasLine()) {
+    if(reader_.IsClosed()) {
+      return false;
+    }
+    int timeout_ms = -1;
+    if(deadline != Deadline::max()) {
+      auto remaining = chrono::duration_cast<chrono::milliseconds>(
+          deadline - chrono::steady_clock::now()).count();
+      if(remaining <= 0) {
+        return false;
+      }
+      timeout_ms = static_cast<int>(remaining);
+    }
+    reader_.WaitForLine(timeout_ms);
   }
 
-  return line;
+  if(reader_.GetLine(line) && line.StartsWith("info ") && line_info_.Parse(line) &&
+     line_info_.has_score) {
+    if(on_info_) {
+      on_info_(line_info_);
+    }
+    // with MultiPV only the first line is the best one. The last line is
+    // kept unless it is less trusted than the one before: a bound after
+    // an exact score, or a line without a variation, which is all there
+    // is for a position without moves.
+    if(GetRank(line_info_) >= GetRank(info_) && line_info_.multipv <= 1) {
+      info_ = line_info_;
+    }
+  }
+  return true;
 }
 
-void ChessEngineInterface::WaitForLine(string line_start) {
-  string line;
-
+bool ChessEngineInterface::WaitForLine(string line_start, TextSpan & line,
+    Deadline deadline) {
   do {
-    line = GetNextLine();
-  } while(line.empty() || line.compare(0, line_start.size(), line_start) != 0);
+    if(!GetNextLine(line, deadline)) {
+      return false;
+    }
+  } while(!line.StartsWith(line_start));
+  return true;
+}
 
+ChessEngineInterface::Deadline ChessEngineInterface::GetDeadline(long timeout_ms) {
+  if(timeout_ms <= 0) {
+    return Deadline::max();
+  }
+  return chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
 }
 
+// writing to an engine that died must not end this process, the error
+// is found when reading from it. SIGPIPE is blocked in this thread during
+// the write and the one it raises is consumed, so the handling of the
+// signal in the rest of the process does not change.
 void ChessEngineInterface::Write(string msg) {
-  write(parentToChild_[WRITE_FD], msg.c_str(), msg.size());
+  if(pid_ <= 0) {
+    return;
+  }
+  sigset_t pipe_set;
+  sigset_t old_set;
+  sigemptyset(&pipe_set);
+  sigaddset(&pipe_set, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+  // a SIGPIPE pending from before is not this write's
+  sigset_t pending;
+  sigpending(&pending);
+  bool was_pending = sigismember(&pending, SIGPIPE);
+
+  ssize_t result = write(parentToChild_[WRITE_FD], msg.c_str(), msg.size());
+  if(result < 0 && errno == EPIPE && !was_pending) {
+    timespec no_wait = {0, 0};
+    sigtimedwait(&pipe_set, nullptr, &no_wait);
+  }
+  pthread_sigmask(SIG_SETMASK, &old_set, nullptr);
+
+  if(result < 0 && verbose_) {
+    cerr << "Cannot write to " << engine_path_ << endl;
+  }
 }
 
 void ChessEngineInterface::WriteLine(string msg) {
   Write(msg.append("\n"));
 }
 
-void ChessEngineInterface::Analyze(Game game, bool analyze_white, bool analyze_black,
-    long time_per_move, long blunder_threshold) {
+GameAnalysis ChessEngineInterface::Analyze(Game game, bool analyze_white,
+    bool analyze_black, const SearchLimits & limits, long blunder_threshold) {
+  GameAnalysis analysis;
+  // the position after a move is the position before the next one, its
+  // evaluation is kept so each position is searched only once
+  Evaluation previous;
+  uint64_t previous_key = 0;
+  bool has_previous = false;
+  // moves played so far, in UCI notation
+  string moves;
+
+  // in incremental mode the engine keeps its hash during the whole game
+  new_game_ = true;
+
   do {
     string pre_FEN = game.FEN();
+    uint64_t pre_key = game.GetKey();
     // game.Move() changes the state of IsWhiteTurn,
     // is_white_turn stores who is going to move next, then
     // game.Move() performs the move and switch to the next player
@@ -173,50 +297,244 @@ void ChessEngineInterface::Analyze(Game game, bool analyze_white, bool analyze_b
     bool is_white_turn = game.IsWhiteTurn();
 
     if(game.Move()) {
-      //cout << game.GetLastMove() << ",";
-      //cout << game.FEN() << ",";
-      //cout.flush();
+      string pre_moves = moves;
+      moves += " " + game.GetMove(game.GetNumMoves() - 1).UCI();
+
       if((is_white_turn && analyze_white) ||
          (!is_white_turn && analyze_black)) {
-        auto engine_option = Analyze(pre_FEN, time_per_move);
-        auto player_option = Analyze(game.FEN(), time_per_move);
-        auto diff = engine_option.first - player_option.first;
-
-        if((is_white_turn && diff > blunder_threshold) ||
-           (!is_white_turn && diff < -blunder_threshold)) {
-          //cout << player_option.first << "," << player_option.second << ",";
-          //cout << engine_option.first << "," << engine_option.second << ",";
+        MoveAnalysis move;
+        move.ply = game.GetNumMoves() - 1;
+        move.move = game.GetLastMove();
+        if(has_previous && previous_key == pre_key) {
+          move.best = previous;
+        } else if(incremental_) {
+          move.best = Search("startpos moves" + pre_moves, pre_key,
+              is_white_turn, true, limits);
+        } else {
+          new_game_ = true;
+          move.best = Search("fen " + pre_FEN, pre_key, is_white_turn, true, limits);
+        }
+        MoveList replies;
+        game.GetLegalMoves(replies);
+        if(incremental_) {
+          move.played = Search("startpos moves" + moves, game.GetKey(),
+              !is_white_turn, replies.Size() > 0, limits);
+        } else {
+          new_game_ = true;
+          move.played = Search("fen " + game.FEN(), game.GetKey(),
+              !is_white_turn, replies.Size() > 0, limits);
         }
+        previous = move.played;
+        previous_key = game.GetKey();
+        has_previous = true;
+        auto diff = move.best.score - move.played.score;
+
+        move.is_blunder = (is_white_turn && diff > blunder_threshold) ||
+                          (!is_white_turn && diff < -blunder_threshold);
+        analysis.moves.push_back(move);
       }
-      //cout << endl;
     } else {
       break;
     }
   } while(true);
+
+  return analysis;
+}
+
+Evaluation ChessEngineInterface::Analyze(string fen, const SearchLimits & limits) {
+  // an invalid FEN is still sent to the engine, but it is not cached
+  Board board(8,8);
+  MoveList moves;
+  uint64_t key = 0;
+  if(board.LoadFEN(fen)) {
+    key = board.GetKey();
+    MoveGenerator::GenerateLegalMoves(board, moves);
+  }
+  new_game_ = true;
+  return Search("fen " + fen, key, fen.find(" b ") == string::npos,
+      key == 0 || moves.Size() > 0, limits);
 }
 
-pair<long, string> ChessEngineInterface::Analyze(string fen, long time_secs) {
-  WriteLine("ucinewgame");
-  WriteLine("position fen " + fen);
-  WriteLine("go movetime " + to_string(time_secs*1000));
-  WaitForLine("bestmove");
-
-  // get best line
-  for(auto it = lines_.rbegin(); it != lines_.rend(); it++) {
-    string str = *it;
-    size_t index1 = str.find(" score cp ");
-    size_t index2 = str.find(" pv ");
-    if(index1 != string::npos && index2 != string::npos) {
-      index1 += string(" score cp ").length();
-      int index1_end = str.find(" ",index1);
-      string value_str = str.substr(index1, index1_end - index1);
-      long value = atol(value_str.c_str());
-      index2 += string(" pv ").length();
-      string movements = str.substr(index2);
-      return make_pair(value, movements);
-    }
-  }
-  return make_pair(0,"");
+// position is what follows "position" in the UCI command, key is the
+// Zobrist key of the position or 0 to skip the cache. An engine that
+// dies or hangs is started again and the search is repeated.
+Evaluation ChessEngineInterface::Search(string position, uint64_t key,
+    bool is_white_turn, bool has_moves, const SearchLimits & limits) {
+  Evaluation evaluation;
+  // a search without limits would never end
+  if(!limits.IsSet()) {
+    if(verbose_) {
+      cerr << "No limits to search " << position << endl;
+    }
+    evaluation.is_valid = false;
+    return evaluation;
+  }
+  if(cache_ != nullptr && key != 0 &&
+     cache_->Find(key, engine_id_, limits, evaluation)) {
+    return evaluation;
+  }
+
+  TextSpan line;
+  bool is_done = false;
+  bool is_cut = false;
+  for(int attempt = 0; attempt < MAX_ATTEMPTS && !is_done; ++attempt) {
+    if(attempt > 0 || pid_ <= 0) {
+      if(verbose_) {
+        cerr << "Restarting " << engine_path_ << endl;
+      }
+      if(!Restart()) {
+        continue;
+      }
+    }
+    is_done = RunSearch(position, limits, has_moves, line, is_cut);
+  }
+  if(!is_done) {
+    evaluation.is_valid = false;
+    return evaluation;
+  }
+
+  // get best line, mate 0 is a position already mated
+  evaluation.score = info_.is_mate ? GetMateScore(info_.score) : info_.score;
+  evaluation.mate = info_.is_mate ? info_.score : 0;
+  evaluation.depth = info_.depth;
+  evaluation.seldepth = info_.seldepth;
+  evaluation.nodes = info_.nodes;
+  evaluation.nps = info_.nps;
+  evaluation.time_ms = info_.time_ms;
+  evaluation.hashfull = info_.hashfull;
+  evaluation.is_bound = info_.bound != UCIInfo::Bound::Exact;
+  for(size_t i = 0; i < info_.pv_length; ++i) {
+    evaluation.line += (i > 0) ? " " + info_.pv[i].UCI() : info_.pv[i].UCI();
+  }
+  // the word after bestmove
+  size_t best_end = 9;
+  while(best_end < line.size && line.data[best_end] != ' ') {
+    best_end++;
+  }
+  // "bestmove (none)" when there are no moves
+  if(best_end > 9 && line.data[9] != '(') {
+    evaluation.best.assign(line.data + 9, best_end - 9);
+  }
+
+  // engines score from the point of view of the side to move
+  if(!is_white_turn) {
+    evaluation.score = -evaluation.score;
+    evaluation.mate = -evaluation.mate;
+  }
+
+  // a search stopped by the watchdog is shorter than the limits say, and
+  // a bound is not the score of the position
+  if(cache_ != nullptr && key != 0 && !is_cut && !evaluation.is_bound) {
+    cache_->Store(key, engine_id_, limits, evaluation);
+  }
+  return evaluation;
+}
+
+// one search up to the bestmove line, false if the engine died or hung.
+// is_cut tells if the watchdog stopped the search before its limits.
+bool ChessEngineInterface::RunSearch(const string & position,
+    const SearchLimits & limits, bool has_moves, TextSpan & line, bool & is_cut) {
+  info_.Clear();
+  is_cut = false;
+  if(new_game_) {
+    WriteLine("ucinewgame");
+    new_game_ = false;
+  }
+  WriteLine("position " + position);
+  WriteLine(GetGoCommand(limits));
+
+  // watchdog: after search_timeout_ms the search is stopped, and an
+  // engine that does not answer a stop, or ignores its movetime, hangs.
+  // An engine silent for silence_timeout_ms is asked isready, which it
+  // must answer even while searching.
+  Deadline stop_deadline = GetDeadline(options_.search_timeout_ms);
+  Deadline hang_deadline = (limits.movetime_ms > 0) ?
+      GetDeadline(limits.movetime_ms + STOP_TIMEOUT_MS) : Deadline::max();
+  Deadline silence_deadline = GetDeadline(options_.silence_timeout_ms);
+  bool is_pinged = false;
+
+  // adaptive stop, once the best move and the score have not changed
+  // for stable_iterations depths in a row
+  int last_depth = 0;
+  PackedMove last_best;
+  long last_score = 0;
+  int num_stable = 0;
+  bool is_stopped = false;
+  // without moves there is no variation to become stable, and an
+  // infinite search would wait for a stop forever
+  if(!has_moves) {
+    WriteLine("stop");
+    is_stopped = true;
+    stop_deadline = Deadline::max();
+    hang_deadline = GetDeadline(STOP_TIMEOUT_MS);
+  }
+  while(true) {
+    Deadline deadline = min(min(stop_deadline, hang_deadline), silence_deadline);
+    if(!GetNextLine(line, deadline)) {
+      if(reader_.IsClosed() || deadline == hang_deadline ||
+         (is_pinged && deadline == silence_deadline)) {
+        if(verbose_) {
+          cerr << engine_path_ << (reader_.IsClosed() ? " died" : " hangs")
+               << " searching " << position << endl;
+        }
+        return false;
+      }
+      if(deadline == silence_deadline) {
+        WriteLine("isready");
+        is_pinged = true;
+        silence_deadline = GetDeadline(STOP_TIMEOUT_MS);
+      } else {
+        WriteLine("stop");
+        is_stopped = true;
+        is_cut = true;
+        stop_deadline = Deadline::max();
+        hang_deadline = GetDeadline(STOP_TIMEOUT_MS);
+      }
+      continue;
+    }
+    silence_deadline = GetDeadline(options_.silence_timeout_ms);
+    is_pinged = false;
+    if(line.StartsWith("bestmove")) {
+      return true;
+    }
+    if(limits.stable_iterations == 0 || is_stopped || info_.depth <= last_depth) {
+      continue;
+    }
+    long score = info_.is_mate ? GetMateScore(info_.score) : info_.score;
+    if(last_depth > 0 && info_.pv[0] == last_best &&
+       labs(score - last_score) <= limits.stable_margin) {
+      num_stable++;
+    } else {
+      num_stable = 0;
+    }
+    last_depth = info_.depth;
+    last_best = info_.pv[0];
+    last_score = score;
+    if(num_stable >= limits.stable_iterations) {
+      WriteLine("stop");
+      is_stopped = true;
+      stop_deadline = Deadline::max();
+      hang_deadline = GetDeadline(STOP_TIMEOUT_MS);
+    }
+  }
+}
+
+string ChessEngineInterface::GetGoCommand(const SearchLimits & limits) {
+  string command = "go";
+  if(limits.depth > 0) {
+    command += " depth " + to_string(limits.depth);
+  }
+  if(limits.nodes > 0) {
+    command += " nodes " + to_string(limits.nodes);
+  }
+  if(limits.movetime_ms > 0) {
+    command += " movetime " + to_string(limits.movetime_ms);
+  }
+  // only the adaptive stop ends the search
+  if(command == "go" && limits.stable_iterations > 0) {
+    command += " infinite";
+  }
+  return command;
 }
 
 }
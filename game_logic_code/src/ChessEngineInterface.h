@@ -7,43 +7,207 @@
 #ifndef CHESSENGINEINTERFACE_H_
 #define CHESSENGINEINTERFACE_H_
 
+#include <chrono>
+#include <functional>
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
+#include "AnalysisCache.h"
 #include "Game.h"
+#include "LineReader.h"
+#include "UCIInfo.h"
 
 namespace acortes {
 namespace chess {
 
+// mates score above any score in centipawns, shorter mates higher
+const long MATE_SCORE = 100000;
+const int MAX_MATE_MOVES = 1000;
+
+// score of a mate in the given moves, negative moves when being mated
+inline long GetMateScore(int mate) {
+  return (mate > 0) ? MATE_SCORE - mate : -MATE_SCORE - mate;
+}
+
+// moves to mate of a score, 0 if it is not a mate
+inline int GetMate(long score) {
+  if(score > MATE_SCORE - MAX_MATE_MOVES) {
+    return MATE_SCORE - score;
+  }
+  return (score < -MATE_SCORE + MAX_MATE_MOVES) ? -MATE_SCORE - score : 0;
+}
+
+// engine opinion about a position, the score is in centipawns from the
+// light side point of view
+struct Evaluation {
+  long score;
+  // moves to mate, negative if the dark side mates, 0 if there is none.
+  // A side already mated has a score of -MATE_SCORE and mate 0, as
+  // GetMate() gives for it.
+  int mate;
+  // depth reached by the engine
+  int depth;
+  int seldepth;
+  uint64_t nodes;
+  uint64_t nps;
+  long time_ms;
+  // permill of the engine hash in use
+  int hashfull;
+  std::string best;
+  std::string line;
+  // false if the engine failed every time it was asked, or the search
+  // had no limits
+  bool is_valid;
+  // the score is only a lower or upper bound, the engine sent no line
+  // with an exact one
+  bool is_bound;
+
+  Evaluation() : score(0), mate(0), depth(0), seldepth(0), nodes(0), nps(0),
+    time_ms(0), hashfull(0), is_valid(true), is_bound(false) {}
+};
+
+// limits of a search, 0 means no limit. Limits can be combined, the
+// search ends at the first one reached. An external engine is not asked
+// to search without any limit, the evaluation is not valid.
+struct SearchLimits {
+  long movetime_ms;
+  int depth;
+  long nodes;
+  // adaptive stop: the search ends once the best move has not changed
+  // and the score has not moved more than stable_margin centipawns for
+  // stable_iterations depths in a row
+  int stable_iterations;
+  int stable_margin;
+
+  SearchLimits() : movetime_ms(0), depth(0), nodes(0), stable_iterations(0),
+    stable_margin(10) {}
+  bool IsSet() const {
+    return movetime_ms > 0 || depth > 0 || nodes > 0 || stable_iterations > 0;
+  }
+};
+
+struct MoveAnalysis {
+  // index of the move in the game, starting at 0
+  size_t ply;
+  std::string move;
+  // position before the move, with the best line of the engine
+  Evaluation best;
+  // position after the move played
+  Evaluation played;
+  bool is_blunder;
+};
+
+struct GameAnalysis {
+  // evaluation of the position, for analysis of a single position
+  Evaluation position;
+  // analyzed moves, for analysis of a whole game
+  std::vector<MoveAnalysis> moves;
+};
+
+// UCI options set after the handshake. Options the engine does not have
+// are not sent.
+struct EngineOptions {
+  int hash_mb;
+  int threads;
+  int multipv;
+  std::string syzygy_path;
+  // any other option, as name and value
+  std::vector<std::pair<std::string, std::string>> custom;
+  // time for the engine to start and answer the handshake
+  long start_timeout_ms;
+  // searches running longer are stopped, 0 for no limit. Their results
+  // are not cached.
+  long search_timeout_ms;
+  // an engine that sends nothing for this long during a search, and then
+  // does not answer isready, hangs. 0 to never ask.
+  long silence_timeout_ms;
+
+  EngineOptions() : hash_mb(32), threads(1), multipv(1), start_timeout_ms(10000),
+    search_timeout_ms(0), silence_timeout_ms(10000) {}
+};
+
+// called with every info line with a score while the engine searches,
+// as sent by the engine, so the score is from the side to move
+typedef std::function<void(const UCIInfo &)> InfoCallback;
+
+// An engine process that dies or stops answering is started again and
+// the search it was doing is repeated, up to MAX_ATTEMPTS times.
 class ChessEngineInterface {
 
 public:
-  ChessEngineInterface(std::string engine_path, bool verbose = false);
-  void Initialize();
-  void Analyze(Game game, bool analyze_white, bool analyze_black,
-      long time_per_move, long blunder_threshold);
+  static const int MAX_ATTEMPTS = 3;
+  // time for the engine to answer a stop or isready, or to end after its
+  // movetime
+  static const long STOP_TIMEOUT_MS = 2000;
+  // time for the engine to quit before it is killed
+  static const long QUIT_TIMEOUT_MS = 1000;
+
+  ChessEngineInterface(std::string engine_path, bool verbose = false,
+      const EngineOptions & options = EngineOptions());
+  // starts the engine, false if it could not be started or did not
+  // answer the handshake
+  bool Initialize();
+  bool IsRunning() const { return pid_ > 0; }
+  // times the engine was started again after failing
+  int GetNumRestarts() const { return num_restarts_; }
+  GameAnalysis Analyze(Game game, bool analyze_white, bool analyze_black,
+      const SearchLimits & limits, long blunder_threshold);
+  Evaluation Analyze(std::string fen, const SearchLimits & limits);
+  // games are sent to the engine as the moves from the initial position,
+  // so its hash is kept from one position to the next
+  void SetIncremental(bool incremental) { incremental_ = incremental; }
+  // positions found in the cache are not searched again, new results
+  // are added to it
+  void SetCache(AnalysisCache * cache) { cache_ = cache; }
+  // the callback is run in the thread calling Analyze(), an empty one
+  // removes it
+  void SetInfoCallback(const InfoCallback & on_info) { on_info_ = on_info; }
+  // "id name" sent by the engine
+  const std::string & GetEngineName() const { return engine_name_; }
+  // true if the engine sent "option name <name>" in the handshake
+  bool HasOption(const std::string & name) const;
   ~ChessEngineInterface();
 
 private:
   std::string engine_path_;
+  EngineOptions options_;
   int parentToChild_[2];
   int childToParent_[2];
   pid_t pid_;
-  static const int BUFFER_SIZE = 1000;
-  char buffer_[BUFFER_SIZE+1];
-  fd_set readfds_;
-  std::string temp_string_;
-  std::vector<std::string> lines_;
-  size_t index_current_line_;
+  LineReader reader_;
+  // last info line with an exact score and a principal variation, or
+  // the best there is if no line had them. It is parsed while reading so
+  // the lines do not need to be kept.
+  UCIInfo info_;
+  UCIInfo line_info_;
   bool verbose_;
+  bool incremental_;
+  // ucinewgame is sent before the next search
+  bool new_game_;
+  std::string engine_name_;
+  std::vector<std::string> engine_options_;
+  uint32_t engine_id_;
+  AnalysisCache * cache_;
+  InfoCallback on_info_;
+  int num_restarts_;
+
+  typedef std::chrono::steady_clock::time_point Deadline;
 
-  size_t Read();
-  void ReadLines(std::vector<std::string> & lines);
-  std::string GetNextLine();
-  void WaitForLine(std::string line_start);
+  bool Restart();
+  void Terminate();
+  bool GetNextLine(TextSpan & line, Deadline deadline = Deadline::max());
+  bool WaitForLine(std::string line_start, TextSpan & line,
+      Deadline deadline = Deadline::max());
+  static Deadline GetDeadline(long timeout_ms);
   void Write(std::string msg);
   void WriteLine(std::string msg);
-  std::pair<long, std::string> Analyze(std::string fen, long time_secs);
+  void SetOption(const std::string & name, const std::string & value);
+  Evaluation Search(std::string position, uint64_t key, bool is_white_turn,
+      bool has_moves, const SearchLimits & limits);
+  bool RunSearch(const std::string & position, const SearchLimits & limits,
+      bool has_moves, TextSpan & line, bool & is_cut);
+  static std::string GetGoCommand(const SearchLimits & limits);
 };
 
 }
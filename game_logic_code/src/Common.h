@@ -7,6 +7,7 @@
 #ifndef COMMON_H_
 #define COMMON_H_
 
+#include <cstring>
 #include <string>
 
 namespace acortes {
@@ -17,6 +18,69 @@ enum class Color{
   Dark
 };
 
+enum class PieceType{
+  Pawn,
+  Knight,
+  Bishop,
+  Rook,
+  Queen,
+  King,
+  None
+};
+
+// castling availability, stored as a bit mask
+enum CastlingRights {
+  NO_CASTLING = 0,
+  LIGHT_SHORT_CASTLE = 1,
+  LIGHT_LONG_CASTLE = 2,
+  DARK_SHORT_CASTLE = 4,
+  DARK_LONG_CASTLE = 8,
+  ALL_CASTLING = 15
+};
+
+const int NUM_COLORS = 2;
+const int NUM_PIECE_TYPES = 6;
+
+inline int ToIndex(Color color) {
+  return static_cast<int>(color);
+}
+
+inline int ToIndex(PieceType type) {
+  return static_cast<int>(type);
+}
+
+inline Color Opponent(Color color) {
+  return (color == Color::Light) ? Color::Dark : Color::Light;
+}
+
+// piece of text inside a buffer owned by someone else, nothing is copied
+struct TextSpan {
+  const char * data;
+  size_t size;
+
+  TextSpan() : data(nullptr), size(0) {}
+  TextSpan(const char * data, size_t size) : data(data), size(size) {}
+  bool Empty() const { return size == 0; }
+  bool operator==(const char * text) const {
+    return strlen(text) == size && (size == 0 || memcmp(data, text, size) == 0);
+  }
+  bool StartsWith(const char * text) const {
+    size_t length = strlen(text);
+    return length <= size && memcmp(data, text, length) == 0;
+  }
+  bool StartsWith(const std::string & text) const {
+    return text.size() <= size &&
+        (text.empty() || memcmp(data, text.data(), text.size()) == 0);
+  }
+  // position of the text, or std::string::npos
+  size_t Find(const char * text) const {
+    const void * found = memmem(data, size, text, strlen(text));
+    return (found != nullptr) ?
+        static_cast<const char *>(found) - data : std::string::npos;
+  }
+  std::string ToString() const { return std::string(data, size); }
+};
+
 inline int GetFile(char file) {
   return static_cast<int>(file -'a');
 }
@@ -0,0 +1,142 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <cassert>
+#include "EnginePool.h"
+#include "PGNPlayer.h"
+#include "Board.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+EnginePool::EnginePool(string engine_path, int num_engines, bool verbose,
+    AnalysisCache * cache, const EngineOptions & options) :
+  engine_path_(engine_path), verbose_(verbose), cache_(cache), options_(options),
+  num_pending_(0), stop_(false) {
+  assert(num_engines > 0);
+  for(int i = 0; i < num_engines; ++i) {
+    threads_.push_back(thread(&EnginePool::Run, this));
+  }
+}
+
+EnginePool::~EnginePool() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stop_ = true;
+  }
+  job_added_.notify_all();
+  for(auto & t : threads_) {
+    t.join();
+  }
+}
+
+size_t EnginePool::AddGame(const PGNReader & game, bool analyze_white,
+    bool analyze_black, const SearchLimits & limits, long blunder_threshold) {
+  Job job = {0, "", game, analyze_white, analyze_black, limits,
+             blunder_threshold, InfoCallback(), nullptr};
+  return Add(job);
+}
+
+size_t EnginePool::AddPosition(string fen, const SearchLimits & limits) {
+  Job job = {0, fen, PGNReader(PGNGame()), false, false, limits, 0,
+             InfoCallback(), nullptr};
+  return Add(job);
+}
+
+future<Evaluation> EnginePool::Submit(string fen, const SearchLimits & limits,
+    const InfoCallback & on_info) {
+  auto promise = make_shared<std::promise<Evaluation>>();
+  Job job = {0, fen, PGNReader(PGNGame()), false, false, limits, 0, on_info,
+             [promise](const GameAnalysis & analysis) {
+               promise->set_value(analysis.position);
+             }};
+  Add(job);
+  return promise->get_future();
+}
+
+future<GameAnalysis> EnginePool::Submit(const PGNReader & game,
+    bool analyze_white, bool analyze_black, const SearchLimits & limits,
+    long blunder_threshold, const InfoCallback & on_info) {
+  auto promise = make_shared<std::promise<GameAnalysis>>();
+  Job job = {0, "", game, analyze_white, analyze_black, limits,
+             blunder_threshold, on_info,
+             [promise](const GameAnalysis & analysis) {
+               promise->set_value(analysis);
+             }};
+  Add(job);
+  return promise->get_future();
+}
+
+// submitted jobs have no place in the results
+size_t EnginePool::Add(Job job) {
+  lock_guard<mutex> lock(mutex_);
+  job.index = results_.size();
+  if(!job.on_done) {
+    results_.push_back(GameAnalysis());
+  }
+  jobs_.push_back(job);
+  num_pending_++;
+  job_added_.notify_one();
+  return job.index;
+}
+
+vector<GameAnalysis> EnginePool::Wait() {
+  unique_lock<mutex> lock(mutex_);
+  job_done_.wait(lock, [this]() { return num_pending_ == 0; });
+  vector<GameAnalysis> results;
+  results.swap(results_);
+  return results;
+}
+
+// thread of one engine
+void EnginePool::Run() {
+  ChessEngineInterface engine(engine_path_, verbose_, options_);
+  engine.SetCache(cache_);
+
+  while(true) {
+    unique_lock<mutex> lock(mutex_);
+    job_added_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+    if(jobs_.empty()) {
+      return;
+    }
+    Job job = jobs_.front();
+    jobs_.pop_front();
+    lock.unlock();
+
+    engine.SetInfoCallback(job.on_info);
+    GameAnalysis analysis;
+    if(!job.fen.empty()) {
+      analysis.position = engine.Analyze(job.fen, job.limits);
+    } else {
+      Board board(8,8);
+      PGNPlayer player1(Color::Light, &job.game);
+      PGNPlayer player2(Color::Dark, &job.game);
+      Game game(&board, &player1, &player2);
+      game.InitialSetup();
+      analysis = engine.Analyze(game, job.analyze_white, job.analyze_black,
+          job.limits, job.blunder_threshold);
+    }
+
+    // the result is handed over without the lock, the caller may be
+    // adding more jobs while it waits for it
+    if(job.on_done) {
+      job.on_done(analysis);
+    }
+    lock.lock();
+    if(!job.on_done) {
+      results_[job.index] = analysis;
+    }
+    num_pending_--;
+    if(num_pending_ == 0) {
+      job_done_.notify_all();
+    }
+  }
+}
+
+}
+}
@@ -0,0 +1,88 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef ENGINEPOOL_H_
+#define ENGINEPOOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ChessEngineInterface.h"
+#include "PGNReader.h"
+
+namespace acortes {
+namespace chess {
+
+// Analysis with several engine processes at the same time. Each engine
+// runs in its own thread, with its own pipes, and takes jobs from a
+// shared queue. A job is a single position or a whole game, which is
+// analyzed by one engine from the first move to the last one.
+class EnginePool {
+public:
+  // all the engines have the same options, the cache, if any, is shared
+  // by all of them
+  EnginePool(std::string engine_path, int num_engines, bool verbose = false,
+      AnalysisCache * cache = nullptr,
+      const EngineOptions & options = EngineOptions());
+  ~EnginePool();
+  // both return the index of the job in the results
+  size_t AddGame(const PGNReader & game, bool analyze_white, bool analyze_black,
+      const SearchLimits & limits, long blunder_threshold);
+  size_t AddPosition(std::string fen, const SearchLimits & limits);
+  // blocks until all the jobs added so far are done, results are in the
+  // order the jobs were added
+  std::vector<GameAnalysis> Wait();
+
+  // the same jobs without blocking and without keeping their results
+  // for Wait(), which still waits for them. The info callback, if any,
+  // is run in the thread of the engine while it searches.
+  std::future<Evaluation> Submit(std::string fen, const SearchLimits & limits,
+      const InfoCallback & on_info = InfoCallback());
+  std::future<GameAnalysis> Submit(const PGNReader & game, bool analyze_white,
+      bool analyze_black, const SearchLimits & limits, long blunder_threshold,
+      const InfoCallback & on_info = InfoCallback());
+
+private:
+  struct Job {
+    size_t index;
+    // empty for games
+    std::string fen;
+    PGNReader game;
+    bool analyze_white;
+    bool analyze_black;
+    SearchLimits limits;
+    long blunder_threshold;
+    InfoCallback on_info;
+    // for submitted jobs, gets the result instead of results_
+    std::function<void(const GameAnalysis &)> on_done;
+  };
+
+  std::string engine_path_;
+  bool verbose_;
+  AnalysisCache * cache_;
+  EngineOptions options_;
+  std::vector<std::thread> threads_;
+  std::deque<Job> jobs_;
+  std::vector<GameAnalysis> results_;
+  size_t num_pending_;
+  bool stop_;
+  std::mutex mutex_;
+  std::condition_variable job_added_;
+  std::condition_variable job_done_;
+
+  size_t Add(Job job);
+  void Run();
+};
+
+}
+}
+
+#endif /* ENGINEPOOL_H_ */
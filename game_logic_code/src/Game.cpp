@@ -9,9 +9,9 @@
 #include "Game.h"
 #include "Board.h"
 #include "Player.h"
-#include "Movement.h"
 #include "Piece.h"
-#include "Pawn.h"
+#include "MoveGenerator.h"
+#include "SAN.h"
 
 using namespace std;
 
@@ -20,37 +20,79 @@ namespace chess {
 
 Game::Game(Board * board, Player * player1, Player * player2) :
   board_(board), players_{player1, player2},
-  is_white_turn_(true),
   halfmove_clock_(0) {
 }
 
 void Game::InitialSetup() {
   players_[0]->InitialSetup(board_);
   players_[1]->InitialSetup(board_);
+  board_->SetSideToMove(Color::Light);
+  board_->SetCastlingRights(ALL_CASTLING);
+  board_->SetEnPassantCandidate(nullptr);
+}
+
+bool Game::IsWhiteTurn() const {
+  return board_->GetSideToMove() == Color::Light;
+}
+
+void Game::GetLegalMoves(MoveList & moves) const {
+  MoveGenerator::GenerateLegalMoves(*board_, moves);
 }
 
 bool Game::Move() {
-  Movement * move = players_[is_white_turn_ ? 0 : 1]->Move();
-
-  if(move != nullptr) {
-    movements_.push_back(move);
-    is_white_turn_ = !is_white_turn_;
-    if(move->is_capture || (move->piece_type == &typeid(acortes::chess::Pawn))) {
-      halfmove_clock_ = 0;
-    } else {
-      halfmove_clock_++;
-    }
-
-    // store en passant candidate
-    if((move->piece->GetLongName() == Pawn::LongName) &&
-       (abs(move->source_rank - move->dest_rank) == 2)) {
-      board_->SetEnPassantCandidate(move->piece);
-    } else {
-      board_->SetEnPassantCandidate(nullptr);
-    }
+  PackedMove move = players_[IsWhiteTurn() ? 0 : 1]->Move();
+
+  if(!move.IsNull()) {
+    MakeMove(move);
+  }
+
+  return !move.IsNull();
+}
+
+void Game::MakeMove(PackedMove move) {
+  UndoRecord record;
+  record.move = move;
+  record.halfmove_clock = halfmove_clock_;
+  record.promoted_pawn = nullptr;
+
+  if(move.IsCapture() ||
+     board_->GetPieceType(move.GetFrom()) == PieceType::Pawn) {
+    halfmove_clock_ = 0;
+  } else {
+    halfmove_clock_++;
   }
 
-  return move!=nullptr;
+  board_->MakeMove(move, record.board);
+
+  // the board keeps the pawn object in the promotion square, the
+  // player provides a piece of the right kind to replace it
+  Piece * pawn = board_->GetPiece(SquareFile(move.GetTo()), SquareRank(move.GetTo()));
+  if(move.IsPromotion() && pawn != nullptr) {
+    Player * player = players_[(pawn->GetColor() == Color::Light) ? 0 : 1];
+    record.promoted_pawn = board_->ReplacePiece(move.GetTo(),
+        player->GetPromotedPiece(move.GetPromotion()));
+  }
+
+  history_.push_back(record);
+}
+
+// take back the last move, returns the move taken back or a null move
+// if there is none
+PackedMove Game::UnmakeMove() {
+  if(history_.empty()) {
+    return PackedMove();
+  }
+
+  const UndoRecord & record = history_.back();
+  if(record.promoted_pawn != nullptr) {
+    board_->ReplacePiece(record.move.GetTo(), record.promoted_pawn);
+  }
+  board_->UnmakeMove(record.move, record.board);
+  halfmove_clock_ = record.halfmove_clock;
+
+  PackedMove move = record.move;
+  history_.pop_back();
+  return move;
 }
 
 string Game::FEN() const {
@@ -58,44 +100,33 @@ string Game::FEN() const {
   string fen = board_->FEN();
 
   // turn to move
-  fen.append((is_white_turn_) ? " w" : " b");
+  fen.append(IsWhiteTurn() ? " w" : " b");
 
-  // TODO: castling availability
+  // castling availability
+  int castling_rights = board_->GetCastlingRights();
   fen.append(" ");
-  bool any_castle = false;
-  if(players_[0]->HasCastle(true)) {
+  if(castling_rights & LIGHT_SHORT_CASTLE) {
     fen.append("K");
-    any_castle = true;
   }
-  if(players_[0]->HasCastle(false)) {
+  if(castling_rights & LIGHT_LONG_CASTLE) {
     fen.append("Q");
-    any_castle = true;
   }
-  if(players_[1]->HasCastle(true)) {
+  if(castling_rights & DARK_SHORT_CASTLE) {
     fen.append("k");
-    any_castle = true;
   }
-  if(players_[1]->HasCastle(false)) {
+  if(castling_rights & DARK_LONG_CASTLE) {
     fen.append("q");
-    any_castle = true;
   }
-  if(!any_castle) {
+  if(castling_rights == NO_CASTLING) {
     fen.append("-");
   }
 
-  // en passant
-  Piece * en_passant_candidate = board_->GetEnPassantCandidate();
+  // en passant, FEN records the position behind the pawn
+  int en_passant_square = board_->GetEnPassantSquare();
   fen.append(" ");
-  if(en_passant_candidate != nullptr) {
-    fen.append(1, GetFile(en_passant_candidate->GetFile()));
-    int rank = en_passant_candidate->GetRank();
-    // FEN records the position behind the pawn
-    if(is_white_turn_) { // black is en passant candidate
-      rank++;
-    } else {  // white is en passant candidate
-      rank--;
-    }
-    fen.append(1, GetRank(rank));
+  if(en_passant_square != -1) {
+    fen.append(1, GetFile(SquareFile(en_passant_square)));
+    fen.append(1, GetRank(SquareRank(en_passant_square)));
   } else {
     fen.append("-");
   }
@@ -106,13 +137,25 @@ string Game::FEN() const {
 
   // fullmove number
   fen.append(" ");
-  fen.append(std::to_string(movements_.size()/2 + 1));
+  fen.append(std::to_string(history_.size()/2 + 1));
 
   return fen;
 }
 
+// Zobrist key of the current position, cheaper than FEN() to identify
+// positions
+uint64_t Game::GetKey() const {
+  return board_->GetKey();
+}
+
+// last move in standard algebraic notation, it is written in the
+// position before the move
 string Game::GetLastMove() {
-  return movements_.back()->move;
+  const UndoRecord & record = history_.back();
+  Board previous(*board_);
+  previous.DetachPieces();
+  previous.UnmakeMove(record.move, record.board);
+  return SAN::Write(previous, record.move);
 }
 
 void Game::Print(char (* printed_board)[64]) const {
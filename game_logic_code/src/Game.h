@@ -9,30 +9,45 @@
 #define GAME_H_
 
 #include "Common.h"
+#include "Board.h"
+#include "PackedMove.h"
+#include <cstdint>
 #include <vector>
 
 namespace acortes {
 namespace chess {
 
-class Board;
 class Player;
-struct Movement;
 
 class Game {
 public:
   Game(Board * board, Player * player1, Player * player2);
   void InitialSetup();
   bool Move();
+  void MakeMove(PackedMove move);
+  PackedMove UnmakeMove();
+  size_t GetNumMoves() const { return history_.size(); }
+  PackedMove GetMove(size_t n) const { return history_[n].move; }
   std::string FEN() const;
-  bool IsWhiteTurn() const { return is_white_turn_;}
+  uint64_t GetKey() const;
+  bool IsWhiteTurn() const;
+  void GetLegalMoves(MoveList & moves) const;
   std::string GetLastMove();
   void Print(char (* printed_board)[64]) const;
 
 private:
+  // everything needed to take back a move
+  struct UndoRecord {
+    PackedMove move;
+    MoveUndo board;
+    int halfmove_clock;
+    // pawn replaced by its promoted piece, if any
+    Piece * promoted_pawn;
+  };
+
   Board *board_;
   Player *(players_[2]);
-  std::vector<Movement *> movements_;
-  bool is_white_turn_;
+  std::vector<UndoRecord> history_;
   int halfmove_clock_;
 };
 
@@ -14,7 +14,7 @@ namespace chess {
 
 const std::string King::LongName = "King";
 
-King::King(Player * player) : Piece(player) {
+King::King(Player * player) : Piece(player, PieceType::King) {
 
 }
 
@@ -11,7 +11,7 @@ namespace chess {
 
 const std::string Knight::LongName = "Knight";
 
-Knight::Knight(Player * player) : Piece(player) {
+Knight::Knight(Player * player) : Piece(player, PieceType::Knight) {
 
 }
 
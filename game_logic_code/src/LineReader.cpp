@@ -0,0 +1,164 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <chrono>
+#include <cstring>
+#include "LineReader.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+// milliseconds left until the deadline, -1 if there is none
+int GetRemaining(int timeout_ms, chrono::steady_clock::time_point start) {
+  if(timeout_ms < 0) {
+    return -1;
+  }
+  auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+      chrono::steady_clock::now() - start).count();
+  return (elapsed < timeout_ms) ? static_cast<int>(timeout_ms - elapsed) : 0;
+}
+
+}
+
+LineReader::LineReader(int fd) :
+  fd_(-1), closed_(false), buffer_(BUFFER_SIZE), begin_(0), end_(0),
+  newline_(0), dropping_line_(false) {
+  SetFd(fd);
+}
+
+void LineReader::SetFd(int fd) {
+  fd_ = fd;
+  closed_ = (fd < 0);
+  begin_ = 0;
+  end_ = 0;
+  newline_ = 0;
+  dropping_line_ = false;
+  if(fd >= 0) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  }
+}
+
+void LineReader::FindNewline(size_t from) {
+  const void * found = memchr(buffer_.data() + from, '\n', end_ - from);
+  newline_ = (found != nullptr) ?
+      static_cast<const char *>(found) - buffer_.data() : end_;
+}
+
+void LineReader::Read() {
+  while(!closed_) {
+    // lines already returned are not needed any more, the rest of the
+    // data goes to the start of the buffer
+    if(begin_ > 0) {
+      memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+      end_ -= begin_;
+      newline_ -= begin_;
+      begin_ = 0;
+    }
+    if(end_ == buffer_.size()) {
+      if(HasLine()) {
+        return;
+      }
+      // a line that does not fit is dropped until its end arrives
+      end_ = 0;
+      newline_ = 0;
+      dropping_line_ = true;
+    }
+
+    ssize_t nbytes = read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+    if(nbytes < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      if(errno != EAGAIN && errno != EWOULDBLOCK) {
+        closed_ = true;
+      }
+      return;
+    }
+    if(nbytes == 0) {
+      closed_ = true;
+      return;
+    }
+
+    // only the new data needs to be searched
+    bool had_line = HasLine();
+    size_t previous_end = end_;
+    end_ += nbytes;
+    if(!had_line) {
+      FindNewline(previous_end);
+    }
+    if(dropping_line_ && HasLine()) {
+      begin_ = newline_ + 1;
+      FindNewline(begin_);
+      dropping_line_ = false;
+    }
+  }
+}
+
+bool LineReader::GetLine(TextSpan & line) {
+  if(!HasLine()) {
+    return false;
+  }
+  line = TextSpan(buffer_.data() + begin_, newline_ - begin_);
+  begin_ = newline_ + 1;
+  FindNewline(begin_);
+  return true;
+}
+
+bool LineReader::WaitForLine(int timeout_ms) {
+  vector<LineReader *> readers(1, this);
+  return Wait(readers, timeout_ms) > 0;
+}
+
+int LineReader::Wait(const vector<LineReader *> & readers, int timeout_ms) {
+  auto start = chrono::steady_clock::now();
+  vector<struct pollfd> fds;
+  vector<LineReader *> polled;
+
+  while(true) {
+    int num_ready = 0;
+    fds.clear();
+    polled.clear();
+    for(auto reader : readers) {
+      if(reader->HasLine()) {
+        num_ready++;
+      } else if(!reader->IsClosed()) {
+        struct pollfd fd = {reader->GetFd(), POLLIN, 0};
+        fds.push_back(fd);
+        polled.push_back(reader);
+      }
+    }
+    if(fds.empty()) {
+      return num_ready;
+    }
+
+    // the rest of the readers are only checked if some line is ready
+    int timeout = (num_ready > 0) ? 0 : GetRemaining(timeout_ms, start);
+    int result = poll(&fds[0], fds.size(), timeout);
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+    for(size_t i = 0; result > 0 && i < fds.size(); ++i) {
+      if(fds[i].revents != 0) {
+        polled[i]->Read();
+        num_ready += polled[i]->HasLine() ? 1 : 0;
+      }
+    }
+    if(num_ready > 0 || result <= 0) {
+      return num_ready;
+    }
+  }
+}
+
+}
+}
@@ -0,0 +1,61 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef LINEREADER_H_
+#define LINEREADER_H_
+
+#include <vector>
+#include "Common.h"
+
+namespace acortes {
+namespace chess {
+
+// Lines read from a pipe. Data arrives in pieces of any size, a line is
+// only available once its end has arrived. Waiting blocks in poll()
+// until there is data, and several readers can be waited on at once.
+// Lines are kept in a buffer of fixed size and returned as views into
+// it, so memory does not grow with the amount of output.
+class LineReader {
+public:
+  // lines longer than the buffer are dropped
+  static const size_t BUFFER_SIZE = 64 * 1024;
+
+  explicit LineReader(int fd = -1);
+  // the descriptor is switched to non blocking mode
+  void SetFd(int fd);
+  int GetFd() const { return fd_; }
+  bool IsClosed() const { return closed_; }
+  // reads what is available without blocking
+  void Read();
+  // next complete line, false if there is none. The line is valid until
+  // the next read.
+  bool GetLine(TextSpan & line);
+  bool HasLine() const { return newline_ < end_; }
+  // blocks until there is a complete line. timeout_ms < 0 waits forever.
+  // False on timeout or when the pipe is closed.
+  bool WaitForLine(int timeout_ms = -1);
+  // blocks until any of the readers has a complete line, returns how
+  // many of them have one
+  static int Wait(const std::vector<LineReader *> & readers, int timeout_ms = -1);
+
+private:
+  int fd_;
+  bool closed_;
+  std::vector<char> buffer_;
+  // unread data goes from begin_ to end_, newline_ is the end of the
+  // first line or end_ if it has not arrived yet
+  size_t begin_;
+  size_t end_;
+  size_t newline_;
+  bool dropping_line_;
+
+  void FindNewline(size_t from);
+};
+
+}
+}
+
+#endif /* LINEREADER_H_ */
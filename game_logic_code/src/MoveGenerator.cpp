@@ -0,0 +1,270 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "MoveGenerator.h"
+#include "Board.h"
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+const Bitboard RANK_1 = 0x00000000000000FFULL;
+const Bitboard RANK_8 = 0xFF00000000000000ULL;
+
+// add one move per destination square, flagging captures
+inline void AddMoves(MoveList & moves, int from, Bitboard destinations,
+    Bitboard theirs) {
+  while(destinations) {
+    int to = PopLSB(destinations);
+    moves.Add(from, to, (theirs & SquareBB(to)) ?
+        PackedMove::CAPTURE : PackedMove::QUIET);
+  }
+}
+
+// a pawn reaching the last rank generates one move per promoted piece
+inline void AddPromotions(MoveList & moves, int from, int to, bool is_capture) {
+  int flags = is_capture ? PackedMove::KNIGHT_PROMOTION_CAPTURE :
+                           PackedMove::KNIGHT_PROMOTION;
+  moves.Add(from, to, flags + 3);  // queen first, it is the usual choice
+  moves.Add(from, to, flags);
+  moves.Add(from, to, flags + 2);
+  moves.Add(from, to, flags + 1);
+}
+
+}
+
+Bitboard MoveGenerator::GetAttackers(const Board & board, int square,
+    Color attacker, Bitboard occupancy) {
+  Bitboard queens = board.GetPieces(PieceType::Queen);
+  Bitboard attackers =
+      (PawnAttacks(Opponent(attacker), square) & board.GetPieces(PieceType::Pawn)) |
+      (KnightAttacks(square) & board.GetPieces(PieceType::Knight)) |
+      (KingAttacks(square) & board.GetPieces(PieceType::King)) |
+      (BishopAttacks(square, occupancy) & (board.GetPieces(PieceType::Bishop) | queens)) |
+      (RookAttacks(square, occupancy) & (board.GetPieces(PieceType::Rook) | queens));
+  return attackers & board.GetPieces(attacker);
+}
+
+bool MoveGenerator::IsSquareAttacked(const Board & board, int square,
+    Color attacker, Bitboard occupancy) {
+  Bitboard theirs = board.GetPieces(attacker);
+  Bitboard queens = board.GetPieces(PieceType::Queen);
+
+  // cheapest tests first
+  if((PawnAttacks(Opponent(attacker), square) & board.GetPieces(PieceType::Pawn) & theirs) ||
+     (KnightAttacks(square) & board.GetPieces(PieceType::Knight) & theirs) ||
+     (KingAttacks(square) & board.GetPieces(PieceType::King) & theirs)) {
+    return true;
+  }
+
+  Bitboard diagonal = (board.GetPieces(PieceType::Bishop) | queens) & theirs;
+  if(diagonal && (BishopAttacks(square, occupancy) & diagonal)) {
+    return true;
+  }
+
+  Bitboard straight = (board.GetPieces(PieceType::Rook) | queens) & theirs;
+  return straight && (RookAttacks(square, occupancy) & straight);
+}
+
+bool MoveGenerator::IsInCheck(const Board & board) {
+  Color us = board.GetSideToMove();
+  return IsSquareAttacked(board, board.GetKingSquare(us), Opponent(us),
+      board.GetOccupancy());
+}
+
+// pieces of the given color that cannot leave the line between their
+// king and an enemy slider
+Bitboard MoveGenerator::GetPinned(const Board & board, Color color,
+    int king_square) {
+  Color them = Opponent(color);
+  Bitboard theirs = board.GetPieces(them);
+  Bitboard queens = board.GetPieces(PieceType::Queen, them);
+  Bitboard pinned = 0;
+
+  // enemy sliders that would attack the king if only enemy pieces
+  // were on the board
+  Bitboard snipers =
+      (RookAttacks(king_square, theirs) &
+          (board.GetPieces(PieceType::Rook, them) | queens)) |
+      (BishopAttacks(king_square, theirs) &
+          (board.GetPieces(PieceType::Bishop, them) | queens));
+
+  while(snipers) {
+    int sniper = PopLSB(snipers);
+    Bitboard blockers = Between(king_square, sniper) & board.GetOccupancy();
+    if(blockers && (blockers & (blockers - 1)) == 0) {
+      pinned |= blockers & board.GetPieces(color);
+    }
+  }
+  return pinned;
+}
+
+void MoveGenerator::GenerateLegalMoves(const Board & board, MoveList & moves) {
+  Color us = board.GetSideToMove();
+  Color them = Opponent(us);
+  Bitboard ours = board.GetPieces(us);
+  Bitboard theirs = board.GetPieces(them);
+  Bitboard occupancy = board.GetOccupancy();
+  int king_square = board.GetKingSquare(us);
+  Bitboard checkers = GetAttackers(board, king_square, them, occupancy);
+
+  // king moves, the king itself is removed so it cannot hide behind
+  // its own square from a slider
+  Bitboard occupancy_without_king = occupancy ^ SquareBB(king_square);
+  Bitboard destinations = KingAttacks(king_square) & ~ours;
+  while(destinations) {
+    int to = PopLSB(destinations);
+    if(!IsSquareAttacked(board, to, them, occupancy_without_king)) {
+      moves.Add(king_square, to, (theirs & SquareBB(to)) ?
+          PackedMove::CAPTURE : PackedMove::QUIET);
+    }
+  }
+
+  // in double check only the king can move
+  if(checkers & (checkers - 1)) {
+    return;
+  }
+
+  // in check, other pieces have to capture the checker or block it
+  Bitboard targets = ~ours;
+  if(checkers) {
+    targets = checkers | Between(king_square, LSB(checkers));
+  } else {
+    GenerateCastles(board, moves);
+  }
+
+  Bitboard pinned = GetPinned(board, us, king_square);
+
+  // a pinned knight can never move
+  Bitboard knights = board.GetPieces(PieceType::Knight, us) & ~pinned;
+  while(knights) {
+    int from = PopLSB(knights);
+    AddMoves(moves, from, KnightAttacks(from) & targets, theirs);
+  }
+
+  Bitboard queens = board.GetPieces(PieceType::Queen, us);
+  Bitboard diagonal = board.GetPieces(PieceType::Bishop, us) | queens;
+  while(diagonal) {
+    int from = PopLSB(diagonal);
+    Bitboard attacks = BishopAttacks(from, occupancy) & targets;
+    if(pinned & SquareBB(from)) {
+      attacks &= Line(king_square, from);
+    }
+    AddMoves(moves, from, attacks, theirs);
+  }
+
+  Bitboard straight = board.GetPieces(PieceType::Rook, us) | queens;
+  while(straight) {
+    int from = PopLSB(straight);
+    Bitboard attacks = RookAttacks(from, occupancy) & targets;
+    if(pinned & SquareBB(from)) {
+      attacks &= Line(king_square, from);
+    }
+    AddMoves(moves, from, attacks, theirs);
+  }
+
+  GeneratePawnMoves(board, moves, targets, pinned, king_square);
+}
+
+void MoveGenerator::GeneratePawnMoves(const Board & board, MoveList & moves,
+    Bitboard targets, Bitboard pinned, int king_square) {
+  Color us = board.GetSideToMove();
+  Color them = Opponent(us);
+  Bitboard theirs = board.GetPieces(them);
+  Bitboard empty = ~board.GetOccupancy();
+  Bitboard pawns = board.GetPieces(PieceType::Pawn, us);
+  const int up = (us == Color::Light) ? 8 : -8;
+  const Bitboard last_rank = (us == Color::Light) ? RANK_8 : RANK_1;
+  const int initial_rank = (us == Color::Light) ? 1 : 6;
+  const int en_passant_square = board.GetEnPassantSquare();
+
+  while(pawns) {
+    int from = PopLSB(pawns);
+    Bitboard allowed = targets;
+    if(pinned & SquareBB(from)) {
+      allowed &= Line(king_square, from);
+    }
+
+    // forward moves
+    int to = from + up;
+    if(empty & SquareBB(to)) {
+      if(allowed & SquareBB(to)) {
+        if(last_rank & SquareBB(to)) {
+          AddPromotions(moves, from, to, false);
+        } else {
+          moves.Add(from, to);
+        }
+      }
+      int to_two_steps = to + up;
+      if(SquareRank(from) == initial_rank &&
+         (empty & allowed & SquareBB(to_two_steps))) {
+        moves.Add(from, to_two_steps, PackedMove::DOUBLE_PAWN_PUSH);
+      }
+    }
+
+    // captures
+    Bitboard attacks = PawnAttacks(us, from);
+    Bitboard captures = attacks & theirs & allowed;
+    while(captures) {
+      to = PopLSB(captures);
+      if(last_rank & SquareBB(to)) {
+        AddPromotions(moves, from, to, true);
+      } else {
+        moves.Add(from, to, PackedMove::CAPTURE);
+      }
+    }
+
+    // en passant removes two pawns from the same rank, which cannot be
+    // handled with the pin mask, so the resulting position is verified
+    if(en_passant_square != -1 && (attacks & SquareBB(en_passant_square))) {
+      int captured = en_passant_square - up;
+      Bitboard occupancy = (board.GetOccupancy() ^ SquareBB(from) ^
+          SquareBB(captured)) | SquareBB(en_passant_square);
+      if((GetAttackers(board, king_square, them, occupancy) &
+          ~SquareBB(captured)) == 0) {
+        moves.Add(from, en_passant_square, PackedMove::EN_PASSANT);
+      }
+    }
+  }
+}
+
+// castles are only generated when the side to move is not in check
+void MoveGenerator::GenerateCastles(const Board & board, MoveList & moves) {
+  Color us = board.GetSideToMove();
+  Color them = Opponent(us);
+  int rights = board.GetCastlingRights();
+  int rank = (us == Color::Light) ? 0 : 7;
+  int short_castle = (us == Color::Light) ? LIGHT_SHORT_CASTLE : DARK_SHORT_CASTLE;
+  int long_castle = (us == Color::Light) ? LIGHT_LONG_CASTLE : DARK_LONG_CASTLE;
+  int king_square = GetSquare(4, rank);
+  Bitboard occupancy = board.GetOccupancy();
+  Bitboard rooks = board.GetPieces(PieceType::Rook, us);
+
+  if(!(rights & (short_castle | long_castle)) ||
+     board.GetKingSquare(us) != king_square) {
+    return;
+  }
+
+  if((rights & short_castle) &&
+     (rooks & SquareBB(GetSquare(7, rank))) &&
+     !(occupancy & Between(king_square, GetSquare(7, rank))) &&
+     !IsSquareAttacked(board, GetSquare(5, rank), them, occupancy) &&
+     !IsSquareAttacked(board, GetSquare(6, rank), them, occupancy)) {
+    moves.Add(king_square, GetSquare(6, rank), PackedMove::SHORT_CASTLE);
+  }
+
+  if((rights & long_castle) &&
+     (rooks & SquareBB(GetSquare(0, rank))) &&
+     !(occupancy & Between(king_square, GetSquare(0, rank))) &&
+     !IsSquareAttacked(board, GetSquare(3, rank), them, occupancy) &&
+     !IsSquareAttacked(board, GetSquare(2, rank), them, occupancy)) {
+    moves.Add(king_square, GetSquare(2, rank), PackedMove::LONG_CASTLE);
+  }
+}
+
+}
+}
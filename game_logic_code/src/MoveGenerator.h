@@ -0,0 +1,41 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef MOVEGENERATOR_H_
+#define MOVEGENERATOR_H_
+
+#include "Common.h"
+#include "Bitboard.h"
+#include "PackedMove.h"
+
+namespace acortes {
+namespace chess {
+
+class Board;
+
+// Enumerates the legal moves of the side to move. Pins and checks are
+// resolved while generating, so every move in the list is legal and no
+// move has to be tried on the board.
+class MoveGenerator {
+public:
+  static void GenerateLegalMoves(const Board & board, MoveList & moves);
+  static bool IsInCheck(const Board & board);
+  static bool IsSquareAttacked(const Board & board, int square, Color attacker,
+      Bitboard occupancy);
+  static Bitboard GetAttackers(const Board & board, int square, Color attacker,
+      Bitboard occupancy);
+
+private:
+  static Bitboard GetPinned(const Board & board, Color color, int king_square);
+  static void GeneratePawnMoves(const Board & board, MoveList & moves,
+      Bitboard targets, Bitboard pinned, int king_square);
+  static void GenerateCastles(const Board & board, MoveList & moves);
+};
+
+}
+}
+
+#endif /* MOVEGENERATOR_H_ */
@@ -0,0 +1,574 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "NativeEngine.h"
+#include "Board.h"
+#include "MoveGenerator.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+const int INFINITE_SCORE = MATE_SCORE + 1;
+// mates found by the search are MATE_SCORE minus the plies to the mate
+const int MATE_IN_MAX_PLY = MATE_SCORE - NativeEngine::MAX_PLY;
+// the clock is read once every this many nodes
+const uint64_t NODES_PER_CHECK = 2048;
+
+const int PIECE_VALUES[NUM_PIECE_TYPES] = {100, 320, 330, 500, 900, 0};
+
+// piece square tables from the light side, the first row is rank 8
+const int PAWN_TABLE[NUM_SQUARES] = {
+   0,  0,  0,  0,  0,  0,  0,  0,
+  50, 50, 50, 50, 50, 50, 50, 50,
+  10, 10, 20, 30, 30, 20, 10, 10,
+   5,  5, 10, 25, 25, 10,  5,  5,
+   0,  0,  0, 20, 20,  0,  0,  0,
+   5, -5,-10,  0,  0,-10, -5,  5,
+   5, 10, 10,-20,-20, 10, 10,  5,
+   0,  0,  0,  0,  0,  0,  0,  0
+};
+
+const int KNIGHT_TABLE[NUM_SQUARES] = {
+  -50,-40,-30,-30,-30,-30,-40,-50,
+  -40,-20,  0,  0,  0,  0,-20,-40,
+  -30,  0, 10, 15, 15, 10,  0,-30,
+  -30,  5, 15, 20, 20, 15,  5,-30,
+  -30,  0, 15, 20, 20, 15,  0,-30,
+  -30,  5, 10, 15, 15, 10,  5,-30,
+  -40,-20,  0,  5,  5,  0,-20,-40,
+  -50,-40,-30,-30,-30,-30,-40,-50
+};
+
+const int BISHOP_TABLE[NUM_SQUARES] = {
+  -20,-10,-10,-10,-10,-10,-10,-20,
+  -10,  0,  0,  0,  0,  0,  0,-10,
+  -10,  0,  5, 10, 10,  5,  0,-10,
+  -10,  5,  5, 10, 10,  5,  5,-10,
+  -10,  0, 10, 10, 10, 10,  0,-10,
+  -10, 10, 10, 10, 10, 10, 10,-10,
+  -10,  5,  0,  0,  0,  0,  5,-10,
+  -20,-10,-10,-10,-10,-10,-10,-20
+};
+
+const int ROOK_TABLE[NUM_SQUARES] = {
+   0,  0,  0,  0,  0,  0,  0,  0,
+   5, 10, 10, 10, 10, 10, 10,  5,
+  -5,  0,  0,  0,  0,  0,  0, -5,
+  -5,  0,  0,  0,  0,  0,  0, -5,
+  -5,  0,  0,  0,  0,  0,  0, -5,
+  -5,  0,  0,  0,  0,  0,  0, -5,
+  -5,  0,  0,  0,  0,  0,  0, -5,
+   0,  0,  0,  5,  5,  0,  0,  0
+};
+
+const int QUEEN_TABLE[NUM_SQUARES] = {
+  -20,-10,-10, -5, -5,-10,-10,-20,
+  -10,  0,  0,  0,  0,  0,  0,-10,
+  -10,  0,  5,  5,  5,  5,  0,-10,
+   -5,  0,  5,  5,  5,  5,  0, -5,
+    0,  0,  5,  5,  5,  5,  0, -5,
+  -10,  5,  5,  5,  5,  5,  0,-10,
+  -10,  0,  5,  0,  0,  0,  0,-10,
+  -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+const int KING_TABLE[NUM_SQUARES] = {
+  -30,-40,-40,-50,-50,-40,-40,-30,
+  -30,-40,-40,-50,-50,-40,-40,-30,
+  -30,-40,-40,-50,-50,-40,-40,-30,
+  -30,-40,-40,-50,-50,-40,-40,-30,
+  -20,-30,-30,-40,-40,-30,-30,-20,
+  -10,-20,-20,-20,-20,-20,-20,-10,
+   20, 20,  0,  0,  0,  0, 20, 20,
+   20, 30, 10,  0,  0, 10, 30, 20
+};
+
+// without queens, or with little else, the king goes to the center
+const int KING_ENDGAME_TABLE[NUM_SQUARES] = {
+  -50,-40,-30,-20,-20,-30,-40,-50,
+  -30,-20,-10,  0,  0,-10,-20,-30,
+  -30,-10, 20, 30, 30, 20,-10,-30,
+  -30,-10, 30, 40, 40, 30,-10,-30,
+  -30,-10, 30, 40, 40, 30,-10,-30,
+  -30,-10, 20, 30, 30, 20,-10,-30,
+  -30,-30,  0,  0,  0,  0,-30,-30,
+  -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+const int * const PIECE_TABLES[NUM_PIECE_TYPES] = {PAWN_TABLE, KNIGHT_TABLE,
+    BISHOP_TABLE, ROOK_TABLE, QUEEN_TABLE, KING_TABLE};
+
+// material of knights, bishops, rooks and queens of both sides below
+// which the endgame king table is used
+const int ENDGAME_MATERIAL = 2 * (PIECE_VALUES[ToIndex(PieceType::Rook)] +
+    PIECE_VALUES[ToIndex(PieceType::Bishop)]);
+
+// order of moves: the move of the table, the one of the last principal
+// variation, captures and promotions by the value of what is won,
+// killers and the history
+const int TABLE_MOVE_SCORE = 1 << 30;
+const int PV_MOVE_SCORE = 1 << 29;
+const int CAPTURE_SCORE = 1 << 24;
+const int KILLER_SCORE = 1 << 22;
+const int MAX_HISTORY = 1 << 20;
+
+// mates are stored in the table from the position, not from the root
+int ToTableScore(int score, int ply) {
+  if(score >= MATE_IN_MAX_PLY) {
+    return score + ply;
+  }
+  return (score <= -MATE_IN_MAX_PLY) ? score - ply : score;
+}
+
+int FromTableScore(int score, int ply) {
+  if(score >= MATE_IN_MAX_PLY) {
+    return score - ply;
+  }
+  return (score <= -MATE_IN_MAX_PLY) ? score + ply : score;
+}
+
+// type of the piece taken by a capture
+PieceType GetCaptured(const Board & board, PackedMove move) {
+  return move.IsEnPassant() ? PieceType::Pawn : board.GetPieceType(move.GetTo());
+}
+
+}
+
+const int NativeEngine::MAX_PLY;
+
+NativeEngine::NativeEngine(size_t hash_mb, int num_threads) :
+  own_table_(new TranspositionTable(hash_mb)), table_(own_table_.get()),
+  nodes_(0), seldepth_(0), is_stopped_(false), can_stop_(false), stop_(nullptr) {
+  for(int i = 1; i < num_threads; ++i) {
+    helpers_.push_back(unique_ptr<NativeEngine>(new NativeEngine(table_)));
+  }
+}
+
+NativeEngine::NativeEngine(TranspositionTable * table) :
+  table_(table), nodes_(0), seldepth_(0), is_stopped_(false), can_stop_(false),
+  stop_(nullptr) {
+}
+
+int NativeEngine::Evaluate(const Board & board) {
+  int non_pawn_material = 0;
+  for(int type = ToIndex(PieceType::Knight); type <= ToIndex(PieceType::Queen); ++type) {
+    non_pawn_material += PIECE_VALUES[type] *
+        PopCount(board.GetPieces(static_cast<PieceType>(type)));
+  }
+  bool is_endgame = board.GetPieces(PieceType::Queen) == 0 ||
+      non_pawn_material <= ENDGAME_MATERIAL + 2 * PIECE_VALUES[ToIndex(PieceType::Queen)];
+
+  int score = 0;
+  for(int type = 0; type < NUM_PIECE_TYPES; ++type) {
+    const int * table = PIECE_TABLES[type];
+    if(type == ToIndex(PieceType::King) && is_endgame) {
+      table = KING_ENDGAME_TABLE;
+    }
+    // tables are read from rank 8 for the light side and mirrored for
+    // the dark side
+    Bitboard light = board.GetPieces(static_cast<PieceType>(type), Color::Light);
+    while(light) {
+      int square = PopLSB(light);
+      score += PIECE_VALUES[type] + table[square ^ 56];
+    }
+    Bitboard dark = board.GetPieces(static_cast<PieceType>(type), Color::Dark);
+    while(dark) {
+      int square = PopLSB(dark);
+      score -= PIECE_VALUES[type] + table[square];
+    }
+  }
+  return (board.GetSideToMove() == Color::Light) ? score : -score;
+}
+
+Evaluation NativeEngine::Analyze(const string & fen, const SearchLimits & limits) {
+  Board board(8,8);
+  if(!board.LoadFEN(fen)) {
+    Evaluation evaluation;
+    evaluation.is_valid = false;
+    return evaluation;
+  }
+  return Analyze(board, limits);
+}
+
+Evaluation NativeEngine::Analyze(const Board & position, const SearchLimits & limits) {
+  Board board(position);
+  board.DetachPieces();
+  Reset(board);
+  limits_ = limits;
+  if(own_table_) {
+    table_->NewSearch();
+  }
+
+  // helpers search until this search ends, they only give their results
+  // through the table
+  stop_helpers_ = false;
+  vector<thread> threads;
+  for(size_t i = 0; i < helpers_.size(); ++i) {
+    threads.push_back(thread(&NativeEngine::RunHelper, helpers_[i].get(),
+        cref(position), static_cast<int>(i + 1), cref(stop_helpers_)));
+  }
+
+  Evaluation evaluation;
+  int max_depth = (limits.depth > 0) ? min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+  PackedMove last_best;
+  int last_score = 0;
+  int num_stable = 0;
+  for(int depth = 1; depth <= max_depth; ++depth) {
+    int score = Search(board, -INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+    if(is_stopped_) {
+      break;
+    }
+    can_stop_ = true;
+
+    evaluation.depth = depth;
+    evaluation.seldepth = seldepth_;
+    evaluation.score = score;
+    evaluation.line.clear();
+    UCIInfo info;
+    info.depth = depth;
+    info.seldepth = seldepth_;
+    info.has_score = true;
+    info.score = score;
+    // the line keeps the whole variation, the info what fits in it
+    info.pv_length = 0;
+    for(int i = 0; i < pv_length_[0]; ++i) {
+      previous_pv_[i] = pv_[0][i];
+      if(info.pv_length < UCIInfo::MAX_PV_LENGTH) {
+        info.pv[info.pv_length++] = pv_[0][i];
+      }
+      evaluation.line += (i > 0) ? " " + pv_[0][i].UCI() : pv_[0][i].UCI();
+    }
+    evaluation.best = (pv_length_[0] > 0) ? pv_[0][0].UCI() : "";
+    if(on_info_) {
+      info.nodes = nodes_;
+      info.time_ms = GetElapsedMilliseconds();
+      on_info_(info);
+    }
+
+    // no moves, or a mate found, deeper searches do not change it
+    if(pv_length_[0] == 0 || abs(score) >= MATE_IN_MAX_PLY) {
+      break;
+    }
+    // the same adaptive stop as with an external engine
+    if(limits.stable_iterations > 0) {
+      bool is_stable = depth > 1 && pv_[0][0] == last_best &&
+                       abs(score - last_score) <= limits.stable_margin;
+      num_stable = is_stable ? num_stable + 1 : 0;
+      last_best = pv_[0][0];
+      last_score = score;
+      if(num_stable >= limits.stable_iterations) {
+        break;
+      }
+    }
+  }
+
+  stop_helpers_ = true;
+  uint64_t nodes = nodes_;
+  for(size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+    nodes += helpers_[i]->nodes_;
+  }
+
+  // mates in moves, as UCI engines give them. A position already mated
+  // keeps -MATE_SCORE.
+  int score = static_cast<int>(evaluation.score);
+  if(abs(score) >= MATE_IN_MAX_PLY && score != -MATE_SCORE) {
+    int plies = MATE_SCORE - abs(score);
+    evaluation.mate = (score > 0) ? (plies + 1) / 2 : -(plies / 2);
+    evaluation.score = GetMateScore(evaluation.mate);
+  }
+  evaluation.nodes = nodes;
+  evaluation.hashfull = table_->GetHashfull();
+  evaluation.time_ms = GetElapsedMilliseconds();
+  evaluation.nps = (evaluation.time_ms > 0) ? nodes * 1000 / evaluation.time_ms : 0;
+
+  // scores are given from the light side
+  if(board.GetSideToMove() == Color::Dark) {
+    evaluation.score = -evaluation.score;
+    evaluation.mate = -evaluation.mate;
+  }
+  return evaluation;
+}
+
+// search of a helper thread, the same iterations as the main one but
+// with every other helper one ply ahead, so they fill the table with
+// the positions the main search is about to reach
+void NativeEngine::RunHelper(const Board & position, int id, const atomic<bool> & stop) {
+  Board board(position);
+  board.DetachPieces();
+  Reset(board);
+  stop_ = &stop;
+  can_stop_ = true;
+  for(int depth = 1 + id % 2; depth < MAX_PLY; ++depth) {
+    Search(board, -INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+    if(is_stopped_) {
+      break;
+    }
+    for(int i = 0; i < pv_length_[0]; ++i) {
+      previous_pv_[i] = pv_[0][i];
+    }
+  }
+}
+
+// state of the search of one thread
+void NativeEngine::Reset(const Board & board) {
+  start_ = Clock::now();
+  nodes_ = 0;
+  seldepth_ = 0;
+  is_stopped_ = false;
+  can_stop_ = false;
+  stop_ = nullptr;
+  fill(&killers_[0][0], &killers_[0][0] + MAX_PLY * 2, PackedMove());
+  fill(previous_pv_, previous_pv_ + MAX_PLY, PackedMove());
+  memset(history_, 0, sizeof(history_));
+  keys_[0] = board.GetKey();
+}
+
+int NativeEngine::Search(Board & board, int alpha, int beta, int depth, int ply) {
+  pv_length_[ply] = ply;
+  if(ply > 0 && IsRepetition(ply)) {
+    return 0;
+  }
+  if(depth <= 0 || ply >= MAX_PLY - 1) {
+    return Quiescence(board, alpha, beta, ply);
+  }
+  nodes_++;
+  CheckLimits();
+  if(is_stopped_) {
+    return 0;
+  }
+
+  // positions already searched deep enough end here, but for the
+  // principal variation, which needs the moves
+  TranspositionTable::Entry entry;
+  PackedMove table_move;
+  bool is_pv = beta - alpha > 1;
+  if(table_->Probe(board.GetKey(), entry)) {
+    table_move = entry.move;
+    int score = FromTableScore(entry.score, ply);
+    if(!is_pv && ply > 0 && entry.depth >= depth &&
+       (entry.bound == TranspositionTable::EXACT ||
+        (entry.bound == TranspositionTable::LOWER_BOUND && score >= beta) ||
+        (entry.bound == TranspositionTable::UPPER_BOUND && score <= alpha))) {
+      return score;
+    }
+  }
+
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  bool is_in_check = MoveGenerator::IsInCheck(board);
+  if(moves.Empty()) {
+    return is_in_check ? -(MATE_SCORE - ply) : 0;
+  }
+  // checks are searched one ply deeper
+  if(is_in_check) {
+    depth++;
+  }
+
+  int scores[MAX_MOVES];
+  ScoreMoves(board, moves, ply, table_move, scores);
+  int original_alpha = alpha;
+  int best_score = -INFINITE_SCORE;
+  PackedMove best_move;
+  MoveUndo undo;
+  for(size_t i = 0; i < moves.Size(); ++i) {
+    PackedMove move = PickMove(moves, scores, i);
+    bool is_quiet = !move.IsCapture() && !move.IsPromotion();
+    board.MakeMove(move, undo);
+    keys_[ply + 1] = board.GetKey();
+
+    // the first move with the full window, the rest with a null window
+    // to prove they are worse, late quiet moves one ply less deep
+    int score;
+    if(i == 0) {
+      score = -Search(board, -beta, -alpha, depth - 1, ply + 1);
+    } else {
+      int reduction = (is_quiet && !is_in_check && i >= 3 && depth >= 3 &&
+                       !MoveGenerator::IsInCheck(board)) ? 1 : 0;
+      score = -Search(board, -alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+      if(score > alpha && (score < beta || reduction > 0)) {
+        score = -Search(board, -beta, -alpha, depth - 1, ply + 1);
+      }
+    }
+    board.UnmakeMove(move, undo);
+    if(is_stopped_) {
+      return 0;
+    }
+
+    if(score > best_score) {
+      best_score = score;
+    }
+    if(score > alpha) {
+      alpha = score;
+      best_move = move;
+      pv_[ply][ply] = move;
+      for(int j = ply + 1; j < pv_length_[ply + 1]; ++j) {
+        pv_[ply][j] = pv_[ply + 1][j];
+      }
+      pv_length_[ply] = max(pv_length_[ply + 1], ply + 1);
+    }
+    if(alpha >= beta) {
+      if(is_quiet) {
+        if(killers_[ply][0] != move) {
+          killers_[ply][1] = killers_[ply][0];
+          killers_[ply][0] = move;
+        }
+        int & history = history_[ToIndex(board.GetSideToMove())][move.GetFrom()][move.GetTo()];
+        history = min(history + depth * depth, MAX_HISTORY);
+      }
+      break;
+    }
+  }
+
+  TranspositionTable::Bound bound = (best_score >= beta) ? TranspositionTable::LOWER_BOUND :
+      (best_score > original_alpha) ? TranspositionTable::EXACT :
+      TranspositionTable::UPPER_BOUND;
+  table_->Store(board.GetKey(), best_move, ToTableScore(best_score, ply), depth, bound);
+  return best_score;
+}
+
+// captures and promotions until the position is quiet, all the moves
+// when in check
+int NativeEngine::Quiescence(Board & board, int alpha, int beta, int ply) {
+  pv_length_[ply] = ply;
+  nodes_++;
+  seldepth_ = max(seldepth_, ply);
+  CheckLimits();
+  if(is_stopped_) {
+    return 0;
+  }
+
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  bool is_in_check = MoveGenerator::IsInCheck(board);
+  if(moves.Empty()) {
+    return is_in_check ? -(MATE_SCORE - ply) : 0;
+  }
+  if(ply >= MAX_PLY - 1) {
+    return Evaluate(board);
+  }
+
+  int best_score = -INFINITE_SCORE;
+  if(!is_in_check) {
+    // the side to move can keep the position as it is
+    best_score = Evaluate(board);
+    if(best_score >= beta) {
+      return best_score;
+    }
+    alpha = max(alpha, best_score);
+    MoveList captures;
+    for(const auto & move : moves) {
+      if(move.IsCapture() || move.IsPromotion()) {
+        captures.Add(move);
+      }
+    }
+    moves = captures;
+  }
+
+  int scores[MAX_MOVES];
+  ScoreMoves(board, moves, ply, PackedMove(), scores);
+  MoveUndo undo;
+  for(size_t i = 0; i < moves.Size(); ++i) {
+    PackedMove move = PickMove(moves, scores, i);
+    board.MakeMove(move, undo);
+    int score = -Quiescence(board, -beta, -alpha, ply + 1);
+    board.UnmakeMove(move, undo);
+    if(is_stopped_) {
+      return 0;
+    }
+    if(score > best_score) {
+      best_score = score;
+    }
+    if(score > alpha) {
+      alpha = score;
+      if(alpha >= beta) {
+        break;
+      }
+    }
+  }
+  return best_score;
+}
+
+void NativeEngine::ScoreMoves(const Board & board, const MoveList & moves, int ply,
+    PackedMove table_move, int * scores) const {
+  const int (& history)[NUM_SQUARES][NUM_SQUARES] =
+      history_[ToIndex(board.GetSideToMove())];
+  for(size_t i = 0; i < moves.Size(); ++i) {
+    PackedMove move = moves[i];
+    if(move == table_move) {
+      scores[i] = TABLE_MOVE_SCORE;
+    } else if(move == previous_pv_[ply]) {
+      scores[i] = PV_MOVE_SCORE;
+    } else if(move.IsCapture() || move.IsPromotion()) {
+      // most valuable victim, then least valuable attacker
+      int victim = move.IsCapture() ? PIECE_VALUES[ToIndex(GetCaptured(board, move))] : 0;
+      int promotion = move.IsPromotion() ? PIECE_VALUES[ToIndex(move.GetPromotion())] : 0;
+      int attacker = ToIndex(board.GetPieceType(move.GetFrom()));
+      scores[i] = CAPTURE_SCORE + (victim + promotion) * 8 - attacker;
+    } else if(move == killers_[ply][0]) {
+      scores[i] = KILLER_SCORE + 1;
+    } else if(move == killers_[ply][1]) {
+      scores[i] = KILLER_SCORE;
+    } else {
+      scores[i] = history[move.GetFrom()][move.GetTo()];
+    }
+  }
+}
+
+// the best scored move from i on, which is moved to i. Moves are only
+// sorted as far as they are searched, most nodes end after a few.
+PackedMove NativeEngine::PickMove(MoveList & moves, int * scores, size_t i) {
+  size_t best = i;
+  for(size_t j = i + 1; j < moves.Size(); ++j) {
+    if(scores[j] > scores[best]) {
+      best = j;
+    }
+  }
+  swap(moves[i], moves[best]);
+  swap(scores[i], scores[best]);
+  return moves[i];
+}
+
+// positions of the same side to move since the root, the position is
+// taken as a draw at the first repetition
+bool NativeEngine::IsRepetition(int ply) const {
+  for(int i = ply - 2; i >= 0; i -= 2) {
+    if(keys_[i] == keys_[ply]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void NativeEngine::CheckLimits() {
+  if(!can_stop_) {
+    return;
+  }
+  if(stop_ != nullptr) {
+    is_stopped_ = stop_->load(memory_order_relaxed);
+  } else if(limits_.nodes > 0 && nodes_ >= static_cast<uint64_t>(limits_.nodes)) {
+    is_stopped_ = true;
+  } else if(limits_.movetime_ms > 0 && nodes_ % NODES_PER_CHECK == 0 &&
+            GetElapsedMilliseconds() >= limits_.movetime_ms) {
+    is_stopped_ = true;
+  }
+}
+
+long NativeEngine::GetElapsedMilliseconds() const {
+  return chrono::duration_cast<chrono::milliseconds>(Clock::now() - start_).count();
+}
+
+}
+}
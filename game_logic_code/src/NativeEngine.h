@@ -0,0 +1,99 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef NATIVEENGINE_H_
+#define NATIVEENGINE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ChessEngineInterface.h"
+#include "PackedMove.h"
+#include "TranspositionTable.h"
+
+namespace acortes {
+namespace chess {
+
+class Board;
+
+// Search in this process, with the same Analyze() as ChessEngineInterface
+// but without an engine to start or talk to. Iterative deepening of an
+// alpha-beta search, principal variation search with late move
+// reductions, followed by a quiescence search of captures and
+// promotions, with a transposition table. With several threads the
+// search is Lazy SMP: helper threads search the same position at
+// staggered depths and share the table, the main thread gives the
+// result. The evaluation is material and piece square tables, which
+// is meant for quick passes over many positions, the positions that
+// deserve more go to an external engine.
+class NativeEngine {
+public:
+  static const int MAX_PLY = 64;
+
+  // with a table of its own
+  explicit NativeEngine(size_t hash_mb = 16, int num_threads = 1);
+  // with a table shared with other engines, which may search at the
+  // same time. The table does not age with its searches, its owner
+  // calls TranspositionTable::NewSearch().
+  explicit NativeEngine(TranspositionTable * table);
+  // the evaluation is not valid if the FEN is not
+  Evaluation Analyze(const std::string & fen, const SearchLimits & limits);
+  Evaluation Analyze(const Board & board, const SearchLimits & limits);
+  // called after each depth with the best line so far, the score is
+  // from the side to move as for an external engine
+  void SetInfoCallback(const InfoCallback & on_info) { on_info_ = on_info; }
+
+  // score of the position for the side to move, in centipawns
+  static int Evaluate(const Board & board);
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  std::unique_ptr<TranspositionTable> own_table_;
+  TranspositionTable * table_;
+  std::vector<std::unique_ptr<NativeEngine>> helpers_;
+  std::atomic<bool> stop_helpers_;
+  SearchLimits limits_;
+  Clock::time_point start_;
+  uint64_t nodes_;
+  int seldepth_;
+  bool is_stopped_;
+  // limits are only checked once there is a result to return
+  bool can_stop_;
+  // set for helpers, which only stop when the main search does
+  const std::atomic<bool> * stop_;
+  InfoCallback on_info_;
+  // principal variation found below each ply, and the one of the last
+  // depth, which is searched first
+  PackedMove pv_[MAX_PLY][MAX_PLY];
+  int pv_length_[MAX_PLY];
+  PackedMove previous_pv_[MAX_PLY];
+  // quiet moves that caused a cutoff, the last two of each ply and how
+  // deep they did it by color and squares
+  PackedMove killers_[MAX_PLY][2];
+  int history_[NUM_COLORS][NUM_SQUARES][NUM_SQUARES];
+  // keys of the positions from the root, for repetitions
+  uint64_t keys_[MAX_PLY + 1];
+
+  void RunHelper(const Board & position, int id, const std::atomic<bool> & stop);
+  void Reset(const Board & board);
+  int Search(Board & board, int alpha, int beta, int depth, int ply);
+  int Quiescence(Board & board, int alpha, int beta, int ply);
+  void ScoreMoves(const Board & board, const MoveList & moves, int ply,
+      PackedMove table_move, int * scores) const;
+  static PackedMove PickMove(MoveList & moves, int * scores, size_t i);
+  bool IsRepetition(int ply) const;
+  void CheckLimits();
+  long GetElapsedMilliseconds() const;
+};
+
+}
+}
+
+#endif /* NATIVEENGINE_H_ */
@@ -0,0 +1,241 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cctype>
+#include <cstring>
+#include "PGNDatabase.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+// length of the game result at p, 0 if there is none
+size_t GetResultLength(const char * p, const char * end) {
+  static const char * results[] = {"1-0", "0-1", "1/2-1/2", "*"};
+  for(const char * result : results) {
+    size_t size = strlen(result);
+    if(static_cast<size_t>(end - p) >= size && memcmp(p, result, size) == 0 &&
+       (p + size == end || isspace(p[size]) || p[size] == ')')) {
+      return size;
+    }
+  }
+  return 0;
+}
+
+// skip a {comment} or a ;comment until the end of the line
+const char * SkipComment(const char * p, const char * end) {
+  const char * close = static_cast<const char *>(
+      memchr(p, (*p == '{') ? '}' : '\n', end - p));
+  return (close != nullptr) ? close + 1 : end;
+}
+
+// skip a (variation), they can be nested and contain comments
+const char * SkipVariation(const char * p, const char * end) {
+  int depth = 0;
+  while(p < end) {
+    if(*p == '{' || *p == ';') {
+      p = SkipComment(p, end);
+      continue;
+    }
+    if(*p == '(') {
+      depth++;
+    } else if(*p == ')' && --depth == 0) {
+      return p + 1;
+    }
+    p++;
+  }
+  return end;
+}
+
+}
+
+TextSpan PGNGame::GetTag(const char * name) const {
+  for(const auto & tag : tags) {
+    if(tag.name == name) {
+      return tag.value;
+    }
+  }
+  return TextSpan();
+}
+
+PGNDatabase::PGNDatabase(const string & filename) :
+  fd_(-1), data_(nullptr), size_(0), is_open_(false) {
+  fd_ = open(filename.c_str(), O_RDONLY);
+  if(fd_ == -1) {
+    return;
+  }
+
+  struct stat file_stat;
+  if(fstat(fd_, &file_stat) == -1) {
+    return;
+  }
+
+  // an empty file cannot be mapped, but it is a valid file without games
+  size_ = file_stat.st_size;
+  if(size_ > 0) {
+    void * data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if(data == MAP_FAILED) {
+      size_ = 0;
+      return;
+    }
+    // pages already read can be dropped by the kernel
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(data);
+  }
+  is_open_ = true;
+}
+
+PGNDatabase::~PGNDatabase() {
+  if(data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+  if(fd_ != -1) {
+    close(fd_);
+  }
+}
+
+PGNDatabase::iterator::iterator(const char * begin, const char * end) :
+  next_(begin), end_(end) {
+  ++(*this);
+}
+
+PGNDatabase::iterator & PGNDatabase::iterator::operator++() {
+  if(!NextGame(next_, end_, game_)) {
+    game_.text = TextSpan();
+  }
+  return *this;
+}
+
+bool PGNDatabase::NextGame(const char *& cursor, const char * end, PGNGame & game) {
+  const char * p = cursor;
+  game.tags.clear();
+
+  while(p < end && isspace(*p)) {
+    p++;
+  }
+  if(p == end) {
+    cursor = end;
+    return false;
+  }
+  const char * start = p;
+
+  // tag pairs, [Name "Value"]
+  while(p < end && *p == '[') {
+    PGNTag tag;
+    p++;
+    while(p < end && isspace(*p)) {
+      p++;
+    }
+    const char * name = p;
+    while(p < end && !isspace(*p) && *p != '"' && *p != ']') {
+      p++;
+    }
+    tag.name = TextSpan(name, p - name);
+    while(p < end && *p != '"' && *p != ']') {
+      p++;
+    }
+    if(p < end && *p == '"') {
+      const char * value = ++p;
+      while(p < end && *p != '"') {
+        p += (*p == '\\' && p + 1 < end) ? 2 : 1;
+      }
+      tag.value = TextSpan(value, p - value);
+    }
+    // rest of the line
+    while(p < end && *p != '\n') {
+      p++;
+    }
+    game.tags.push_back(tag);
+    while(p < end && isspace(*p)) {
+      p++;
+    }
+  }
+
+  // the move text ends with the result, or with the tags of the next
+  // game for files that do not write it
+  const char * movetext = p;
+  const char * movetext_end = end;
+  int depth = 0;
+  while(p < end) {
+    if(*p == '{' || *p == ';') {
+      p = SkipComment(p, end);
+      continue;
+    }
+    if(*p == '(') {
+      depth++;
+    } else if(*p == ')' && depth > 0) {
+      depth--;
+    } else if(depth == 0 && (p == movetext || isspace(p[-1]) || p[-1] == '}')) {
+      if(*p == '[' && p[-1] == '\n') {
+        movetext_end = p;
+        break;
+      }
+      size_t result_length = GetResultLength(p, end);
+      if(result_length > 0) {
+        p += result_length;
+        movetext_end = p;
+        break;
+      }
+    }
+    p++;
+  }
+
+  while(movetext_end > movetext && isspace(movetext_end[-1])) {
+    movetext_end--;
+  }
+  game.movetext = TextSpan(movetext, movetext_end - movetext);
+  game.text = TextSpan(start, movetext_end - start);
+  cursor = p;
+  return true;
+}
+
+bool PGNDatabase::NextMove(const char *& cursor, const char * end, TextSpan & move) {
+  const char * p = cursor;
+
+  while(p < end) {
+    if(isspace(*p) || *p == '.' || *p == ')') {
+      p++;
+    } else if(*p == '{' || *p == ';') {
+      p = SkipComment(p, end);
+    } else if(*p == '(') {
+      p = SkipVariation(p, end);
+    } else if(*p == '$') {
+      // numeric annotation glyph
+      p++;
+      while(p < end && isdigit(*p)) {
+        p++;
+      }
+    } else if(GetResultLength(p, end) > 0) {
+      break;
+    } else if(isdigit(*p) && !(p + 1 < end && p[1] == '-')) {
+      // move number, castles written with zeros are moves
+      while(p < end && isdigit(*p)) {
+        p++;
+      }
+    } else {
+      const char * start = p;
+      while(p < end && !isspace(*p) && strchr("{};()$", *p) == nullptr) {
+        p++;
+      }
+      move = TextSpan(start, p - start);
+      cursor = p;
+      return true;
+    }
+  }
+
+  cursor = p;
+  return false;
+}
+
+}
+}
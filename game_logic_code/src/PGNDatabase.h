@@ -0,0 +1,91 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef PGNDATABASE_H_
+#define PGNDATABASE_H_
+
+#include <iterator>
+#include <string>
+#include <vector>
+#include "Common.h"
+
+namespace acortes {
+namespace chess {
+
+struct PGNTag {
+  TextSpan name;
+  // value without quotes, escaped characters are left as they are
+  TextSpan value;
+};
+
+// one game of a PGN file, all the spans point into the file
+struct PGNGame {
+  std::vector<PGNTag> tags;
+  // the whole game, tags included
+  TextSpan text;
+  // moves, comments, variations and result
+  TextSpan movetext;
+
+  // empty span if the tag is not present
+  TextSpan GetTag(const char * name) const;
+};
+
+// PGN file with any number of games. The file is mapped in memory and
+// the games are found one at a time while iterating, so memory use does
+// not depend on the size of the file.
+class PGNDatabase {
+public:
+  class iterator : public std::iterator<std::input_iterator_tag, PGNGame> {
+  public:
+    iterator() : next_(nullptr), end_(nullptr) {}
+    const PGNGame & operator*() const { return game_; }
+    const PGNGame * operator->() const { return &game_; }
+    iterator & operator++();
+    bool operator==(const iterator & other) const {
+      return game_.text.data == other.game_.text.data;
+    }
+    bool operator!=(const iterator & other) const { return !(*this == other); }
+
+  private:
+    friend class PGNDatabase;
+    iterator(const char * begin, const char * end);
+
+    // the tags vector is reused from one game to the next
+    PGNGame game_;
+    const char * next_;
+    const char * end_;
+  };
+
+  explicit PGNDatabase(const std::string & filename);
+  ~PGNDatabase();
+  bool IsOpen() const { return is_open_; }
+  iterator begin() const { return iterator(data_, data_ + size_); }
+  iterator end() const { return iterator(); }
+  const char * GetData() const { return data_; }
+  size_t GetSize() const { return size_; }
+
+  // finds the next move of a move text and advances the cursor after
+  // it. Move numbers, comments, annotations and variations are skipped.
+  // Returns false at the result or at the end of the text.
+  static bool NextMove(const char *& cursor, const char * end, TextSpan & move);
+  // finds the game starting at or after the cursor and advances the
+  // cursor to the end of it. Returns false if there are no more games.
+  static bool NextGame(const char *& cursor, const char * end, PGNGame & game);
+
+private:
+  int fd_;
+  const char * data_;
+  size_t size_;
+  bool is_open_;
+
+  PGNDatabase(const PGNDatabase &);
+  PGNDatabase & operator=(const PGNDatabase &);
+};
+
+}
+}
+
+#endif /* PGNDATABASE_H_ */
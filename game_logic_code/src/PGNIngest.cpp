@@ -0,0 +1,152 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <atomic>
+#include <cassert>
+#include <mutex>
+#include <thread>
+#include "PGNIngest.h"
+#include "PGNReader.h"
+#include "PGNPlayer.h"
+#include "Board.h"
+#include "Game.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+// chunks per thread, smaller chunks balance the work better
+const size_t CHUNKS_PER_THREAD = 8;
+
+// start of the first game boundary at or after p
+const char * FindGameBoundary(const char * p, const char * end) {
+  static const char pattern[] = "\n[Event";
+  const size_t pattern_size = sizeof(pattern) - 1;
+
+  while(p < end) {
+    const char * found = static_cast<const char *>(
+        memmem(p, end - p, pattern, pattern_size));
+    if(found == nullptr) {
+      return end;
+    }
+    // the line before shall be blank, maybe with a carriage return
+    const char * previous = found;
+    if(previous > p && previous[-1] == '\r') {
+      previous--;
+    }
+    if(previous > p && previous[-1] == '\n') {
+      return found + 1;
+    }
+    p = found + 1;
+  }
+  return end;
+}
+
+}
+
+PGNIngest::PGNIngest(int num_threads) : num_threads_(num_threads) {
+  assert(num_threads > 0);
+}
+
+vector<TextSpan> PGNIngest::Split(const char * data, size_t size,
+    size_t num_chunks) {
+  vector<TextSpan> chunks;
+  const char * end = data + size;
+  const char * start = data;
+
+  for(size_t i = 1; i <= num_chunks && start < end; ++i) {
+    const char * chunk_end = end;
+    if(i < num_chunks) {
+      chunk_end = FindGameBoundary(max(start, data + size * i / num_chunks), end);
+    }
+    if(chunk_end > start) {
+      chunks.push_back(TextSpan(start, chunk_end - start));
+      start = chunk_end;
+    }
+  }
+
+  return chunks;
+}
+
+PGNGameSummary PGNIngest::Replay(const PGNGame & game) {
+  PGNGameSummary summary;
+  summary.index = 0;
+  summary.event = game.GetTag("Event").ToString();
+  summary.white = game.GetTag("White").ToString();
+  summary.black = game.GetTag("Black").ToString();
+  summary.result = game.GetTag("Result").ToString();
+
+  Board board(8,8);
+  PGNReader pgn(game);
+  PGNPlayer player1(Color::Light, &pgn);
+  PGNPlayer player2(Color::Dark, &pgn);
+  Game replay(&board, &player1, &player2);
+  replay.InitialSetup();
+  while(replay.Move()) {
+  }
+
+  summary.num_moves = replay.GetNumMoves();
+  summary.num_errors = pgn.GetNumErrors();
+  summary.final_fen = replay.FEN();
+  summary.final_key = replay.GetKey();
+  return summary;
+}
+
+size_t PGNIngest::Run(const PGNDatabase & database, const Callback & callback) {
+  vector<TextSpan> chunks = Split(database.GetData(), database.GetSize(),
+      num_threads_ * CHUNKS_PER_THREAD);
+
+  // summaries of the chunks finished before some previous chunk, they
+  // wait here until they can be delivered in order
+  vector<vector<PGNGameSummary>> pending(chunks.size());
+  vector<bool> done(chunks.size(), false);
+  size_t next_to_deliver = 0;
+  size_t num_games = 0;
+  mutex pending_mutex;
+
+  // each thread takes the next chunk not yet replayed
+  atomic<size_t> next_chunk(0);
+  auto worker = [&]() {
+    PGNGame game;
+    for(size_t i = next_chunk++; i < chunks.size(); i = next_chunk++) {
+      vector<PGNGameSummary> summaries;
+      const char * cursor = chunks[i].data;
+      const char * end = chunks[i].data + chunks[i].size;
+      while(PGNDatabase::NextGame(cursor, end, game)) {
+        summaries.push_back(Replay(game));
+      }
+
+      lock_guard<mutex> lock(pending_mutex);
+      pending[i].swap(summaries);
+      done[i] = true;
+      while(next_to_deliver < chunks.size() && done[next_to_deliver]) {
+        for(auto & summary : pending[next_to_deliver]) {
+          summary.index = num_games++;
+          callback(summary);
+        }
+        vector<PGNGameSummary>().swap(pending[next_to_deliver]);
+        next_to_deliver++;
+      }
+    }
+  };
+
+  vector<thread> threads;
+  for(int i = 1; i < num_threads_; ++i) {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for(auto & t : threads) {
+    t.join();
+  }
+
+  return num_games;
+}
+
+}
+}
@@ -0,0 +1,58 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef PGNINGEST_H_
+#define PGNINGEST_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "PGNDatabase.h"
+
+namespace acortes {
+namespace chess {
+
+// what is left of a game after replaying it
+struct PGNGameSummary {
+  // position of the game in the file, starting at 0
+  size_t index;
+  std::string event;
+  std::string white;
+  std::string black;
+  std::string result;
+  size_t num_moves;
+  // tokens of the move text that are not legal moves
+  size_t num_errors;
+  std::string final_fen;
+  uint64_t final_key;
+};
+
+// Replays all the games of a PGN file using all the cores. The file is
+// split in chunks at game boundaries, a blank line followed by [Event,
+// and the chunks are replayed by a pool of threads. Summaries are
+// delivered in the order of the games in the file.
+class PGNIngest {
+public:
+  typedef std::function<void(const PGNGameSummary &)> Callback;
+
+  explicit PGNIngest(int num_threads);
+  // returns the number of games. The callback is called from one thread
+  // at a time.
+  size_t Run(const PGNDatabase & database, const Callback & callback);
+
+  static std::vector<TextSpan> Split(const char * data, size_t size,
+      size_t num_chunks);
+  static PGNGameSummary Replay(const PGNGame & game);
+
+private:
+  int num_threads_;
+};
+
+}
+}
+
+#endif /* PGNINGEST_H_ */
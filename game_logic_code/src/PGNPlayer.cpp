@@ -8,7 +8,6 @@
 #include <cassert>
 #include "PGNPlayer.h"
 #include "PGNReader.h"
-#include "Movement.h"
 
 namespace acortes {
 namespace chess {
@@ -27,10 +26,10 @@ PGNPlayer::~PGNPlayer() {
 
 }
 
-Movement * PGNPlayer::GetPartialMoveInformation() {
-  Movement * move = pgn_reader_->GetMove(current_move_);
+PackedMove PGNPlayer::GetNextMove() {
+  PackedMove move = pgn_reader_->GetMove(current_move_);
 
-  if(move != nullptr) {
+  if(!move.IsNull()) {
     current_move_ += 2;
   }
 
@@ -22,7 +22,7 @@ public:
 private:
   const PGNReader * const pgn_reader_;
   unsigned int current_move_;
-  Movement * GetPartialMoveInformation();
+  PackedMove GetNextMove();
 };
 
 }
@@ -8,23 +8,38 @@
 #define PGNREADER_H_
 
 #include "Common.h"
+#include "PackedMove.h"
+#include "PGNDatabase.h"
+#include <cstdint>
 #include <vector>
 
 namespace acortes {
 namespace chess {
 
-class Piece;
-struct Movement;
-
+// Moves of a game in a PGN file. Each move is resolved against the
+// position when the file is read and kept as a PackedMove, the SAN text
+// is only kept on request.
 class PGNReader {
 public:
-  PGNReader(std::string filename);
-  ~PGNReader();
-  Movement* GetMove(unsigned int n) const;
+  // first game of the file
+  PGNReader(std::string filename, bool keep_san = false);
+  explicit PGNReader(const PGNGame & game, bool keep_san = false);
+  PackedMove GetMove(unsigned int n) const;
+  // empty if the text was not kept
+  std::string GetSAN(unsigned int n) const;
+  size_t GetNumMoves() const { return moves_.size(); }
+  // tokens of the move text that are not legal moves
+  size_t GetNumErrors() const { return num_errors_; }
 
 private:
-  std::vector<Movement *> moves_;
-  Movement* ParseMove(std::string move);
+  std::vector<PackedMove> moves_;
+  // text of all moves one after the other, move n goes from
+  // san_offsets_[n] to san_offsets_[n+1]
+  std::string san_;
+  std::vector<uint32_t> san_offsets_;
+  size_t num_errors_;
+
+  void ReadMoves(const TextSpan & movetext, bool keep_san);
 };
 
 }
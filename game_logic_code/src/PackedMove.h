@@ -0,0 +1,117 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef PACKEDMOVE_H_
+#define PACKEDMOVE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include "Common.h"
+#include "Bitboard.h"
+
+namespace acortes {
+namespace chess {
+
+// A move packed in 16 bits: source square in bits 0-5, destination
+// square in bits 6-11 and the move flags in bits 12-15. The flags
+// follow the usual layout, bit 14 marks captures, bit 15 promotions
+// and the lower two bits select the promoted piece.
+class PackedMove {
+public:
+  enum Flags {
+    QUIET = 0,
+    DOUBLE_PAWN_PUSH = 1,
+    SHORT_CASTLE = 2,
+    LONG_CASTLE = 3,
+    CAPTURE = 4,
+    EN_PASSANT = 5,
+    KNIGHT_PROMOTION = 8,
+    BISHOP_PROMOTION = 9,
+    ROOK_PROMOTION = 10,
+    QUEEN_PROMOTION = 11,
+    KNIGHT_PROMOTION_CAPTURE = 12,
+    BISHOP_PROMOTION_CAPTURE = 13,
+    ROOK_PROMOTION_CAPTURE = 14,
+    QUEEN_PROMOTION_CAPTURE = 15
+  };
+
+  PackedMove() : data_(0) {}
+  PackedMove(int from, int to, int flags = QUIET) :
+    data_(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+  int GetFrom() const { return data_ & 0x3f; }
+  int GetTo() const { return (data_ >> 6) & 0x3f; }
+  int GetFlags() const { return data_ >> 12; }
+  bool IsNull() const { return data_ == 0; }
+  bool IsCapture() const { return (data_ & 0x4000) != 0; }
+  bool IsPromotion() const { return (data_ & 0x8000) != 0; }
+  bool IsEnPassant() const { return GetFlags() == EN_PASSANT; }
+  bool IsCastle() const {
+    return GetFlags() == SHORT_CASTLE || GetFlags() == LONG_CASTLE;
+  }
+  // type of the promoted piece, only meaningful for promotions
+  PieceType GetPromotion() const {
+    return static_cast<PieceType>(ToIndex(PieceType::Knight) + (GetFlags() & 3));
+  }
+  uint16_t GetData() const { return data_; }
+
+  // long algebraic notation used by UCI engines, e.g. e2e4 or e7e8q
+  std::string UCI() const;
+
+  bool operator==(const PackedMove & other) const { return data_ == other.data_; }
+  bool operator!=(const PackedMove & other) const { return data_ != other.data_; }
+
+private:
+  uint16_t data_;
+};
+
+// upper bound of legal moves in any reachable position is 218
+const size_t MAX_MOVES = 256;
+
+// Fixed capacity list of moves, meant to live on the stack.
+class MoveList {
+public:
+  MoveList() : size_(0) {}
+  void Add(PackedMove move) {
+    assert(size_ < MAX_MOVES);
+    moves_[size_++] = move;
+  }
+  void Add(int from, int to, int flags = PackedMove::QUIET) {
+    Add(PackedMove(from, to, flags));
+  }
+  void Clear() { size_ = 0; }
+  size_t Size() const { return size_; }
+  bool Empty() const { return size_ == 0; }
+  PackedMove operator[](size_t i) const { return moves_[i]; }
+  PackedMove & operator[](size_t i) { return moves_[i]; }
+  const PackedMove * begin() const { return moves_; }
+  const PackedMove * end() const { return moves_ + size_; }
+  PackedMove * begin() { return moves_; }
+  PackedMove * end() { return moves_ + size_; }
+
+private:
+  PackedMove moves_[MAX_MOVES];
+  size_t size_;
+};
+
+inline std::string PackedMove::UCI() const {
+  static const char promotions[] = "nbrq";
+  std::string uci;
+  uci += chess::GetFile(SquareFile(GetFrom()));
+  uci += chess::GetRank(SquareRank(GetFrom()));
+  uci += chess::GetFile(SquareFile(GetTo()));
+  uci += chess::GetRank(SquareRank(GetTo()));
+  if(IsPromotion()) {
+    uci += promotions[GetFlags() & 3];
+  }
+  return uci;
+}
+
+}
+}
+
+#endif /* PACKEDMOVE_H_ */
@@ -13,7 +13,7 @@ namespace chess {
 
 const std::string Pawn::LongName = "Pawn";
 
-Pawn::Pawn(Player * player) : Piece(player) {
+Pawn::Pawn(Player * player) : Piece(player, PieceType::Pawn) {
 
 }
 
@@ -38,10 +38,10 @@ bool Pawn::IsValidMove(const int new_file, const int new_rank) const {
   // when they are in the starting position, they can move two squares
   // No pieces should be in front of the pawn
   if (new_file == file_ &&
-      board_->GetPiece(file_, rank_one_step) == nullptr &&
+      board_->IsEmpty(file_, rank_one_step) &&
       ( (new_rank == rank_one_step) ||
         (rank_ == rank_initial && new_rank == rank_two_steps &&
-         board_->GetPiece(file_, rank_two_steps) == nullptr))) {
+         board_->IsEmpty(file_, rank_two_steps)))) {
     return true;
   }
 
@@ -0,0 +1,114 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <cassert>
+#include <thread>
+#include "Perft.h"
+#include "Board.h"
+#include "MoveGenerator.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+Perft::Perft(size_t hash_size_mb) : table_mask_(0) {
+  if(hash_size_mb > 0) {
+    // biggest power of two number of entries that fits
+    size_t entries = 1;
+    while(entries * 2 * sizeof(HashEntry) <= hash_size_mb * 1024 * 1024) {
+      entries *= 2;
+    }
+    table_.reset(new HashEntry[entries]);
+    for(size_t i = 0; i < entries; ++i) {
+      table_[i].key = 0;
+      table_[i].data = 0;
+    }
+    table_mask_ = entries - 1;
+  }
+}
+
+uint64_t Perft::Count(const Board & board, int depth) {
+  Board copy(board);
+  copy.DetachPieces();
+  return Search(copy, depth);
+}
+
+uint64_t Perft::Search(Board & board, int depth) {
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+
+  // leaf nodes are not visited, their number is the number of moves
+  if(depth <= 1) {
+    return (depth == 1) ? moves.Size() : 1;
+  }
+
+  uint64_t key = 0;
+  HashEntry * entry = nullptr;
+  if(table_) {
+    key = board.GetKey();
+    entry = &table_[key & table_mask_];
+    uint64_t data = entry->data.load(memory_order_relaxed);
+    if((entry->key.load(memory_order_relaxed) ^ data) == key &&
+       static_cast<int>(data & 0xff) == depth) {
+      return data >> 8;
+    }
+  }
+
+  uint64_t nodes = 0;
+  MoveUndo undo;
+  for(const auto & move : moves) {
+    board.MakeMove(move, undo);
+    nodes += Search(board, depth - 1);
+    board.UnmakeMove(move, undo);
+  }
+
+  if(entry != nullptr) {
+    uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth);
+    entry->key.store(key ^ data, memory_order_relaxed);
+    entry->data.store(data, memory_order_relaxed);
+  }
+  return nodes;
+}
+
+vector<pair<PackedMove, uint64_t>> Perft::Divide(const Board & board,
+    int depth, int num_threads) {
+  assert(depth >= 1);
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+
+  vector<pair<PackedMove, uint64_t>> result;
+  for(const auto & move : moves) {
+    result.push_back(make_pair(move, 0));
+  }
+
+  // each thread takes the next root move not yet searched
+  atomic<size_t> next_move(0);
+  auto worker = [&]() {
+    Board copy(board);
+    copy.DetachPieces();
+    MoveUndo undo;
+    for(size_t i = next_move++; i < result.size(); i = next_move++) {
+      copy.MakeMove(result[i].first, undo);
+      result[i].second = Search(copy, depth - 1);
+      copy.UnmakeMove(result[i].first, undo);
+    }
+  };
+
+  vector<thread> threads;
+  for(int i = 1; i < num_threads; ++i) {
+    threads.push_back(thread(worker));
+  }
+  worker();
+  for(auto & t : threads) {
+    t.join();
+  }
+
+  return result;
+}
+
+}
+}
@@ -0,0 +1,52 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef PERFT_H_
+#define PERFT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "PackedMove.h"
+
+namespace acortes {
+namespace chess {
+
+class Board;
+
+// Counts the leaf nodes of the legal move tree up to a given depth.
+// The counts of well known positions are published, which makes this
+// the reference test of the move generator and of make/unmake.
+class Perft {
+public:
+  // hash_size_mb == 0 disables the hash table
+  explicit Perft(size_t hash_size_mb = 0);
+  uint64_t Count(const Board & board, int depth);
+  // nodes below each root move. Root moves are distributed among
+  // num_threads threads, each one working on its own copy of the board.
+  std::vector<std::pair<PackedMove, uint64_t>> Divide(const Board & board,
+      int depth, int num_threads = 1);
+
+private:
+  // the key is stored xor'ed with the data, so an entry written at the
+  // same time by two threads is detected and ignored
+  struct HashEntry {
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> data;
+  };
+
+  std::unique_ptr<HashEntry[]> table_;
+  size_t table_mask_;
+
+  uint64_t Search(Board & board, int depth);
+};
+
+}
+}
+
+#endif /* PERFT_H_ */
@@ -14,8 +14,8 @@
 namespace acortes {
 namespace chess {
 
-Piece::Piece(Player * player) :
-  player_(player), board_(nullptr) {
+Piece::Piece(Player * player, PieceType type) :
+  type_(type), player_(player), board_(nullptr) {
   assert(player != nullptr);
   file_ = -1;
   rank_ = -1;
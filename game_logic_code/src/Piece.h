@@ -17,11 +17,12 @@ class Board;
 
 class Piece {
 public:
-  Piece(Player * player);
+  Piece(Player * player, PieceType type);
   virtual ~Piece();
   void Put(Board * board, int file, int rank);
   virtual void Move(int file, int rank, bool is_capture);
   Color GetColor() const;
+  PieceType GetType() const { return type_; }
   std::string FEN() const;
   virtual bool IsValidMove(int new_file, int new_rank) const = 0;
   virtual std::string GetLongName() const = 0;
@@ -29,12 +30,14 @@ public:
   int GetFile() {return file_;}
   int GetRank() {return rank_;}
   int GetNumMoves() { return num_moves_; }
+  bool IsOnBoard() const { return board_ != nullptr; }
 
   friend class Board;
 protected:
   int file_;
   int rank_;
   int num_moves_;
+  PieceType type_;
   Player * player_;
   Board * board_;
 
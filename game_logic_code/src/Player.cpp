@@ -14,7 +14,6 @@
 #include "Bishop.h"
 #include "Queen.h"
 #include "King.h"
-#include "Movement.h"
 
 namespace acortes {
 namespace chess {
@@ -52,23 +51,41 @@ void Player::InitialSetup(Board *board) {
   }
 }
 
-Movement * Player::Move() {
-  Movement *move = GetPartialMoveInformation();
+PackedMove Player::Move() {
+  return GetNextMove();
+}
 
-  if(move != nullptr) {
-    if(move->is_short_castle || move->is_long_castle) {
-      assert(move->is_short_castle ^ move->is_long_castle);
-      King * king = static_cast<King *>(FindPiece(King::LongName));
-      king->Castle(move->is_short_castle);
-      move->piece = king;
-    } else {
-      Piece * piece = FindPiece(move);
-      piece->Move(move->dest_file, move->dest_rank, move->is_capture);
+// piece replacing a promoted pawn. Pieces off the board are reused,
+// otherwise a new one is created
+Piece * Player::GetPromotedPiece(PieceType type) {
+  for(auto const & piece : pieces_) {
+    if(piece->GetType() == type && !piece->IsOnBoard()) {
+      return piece;
     }
-    return move;
   }
 
-  return nullptr;
+  Piece * piece = nullptr;
+  switch(type) {
+    case PieceType::Knight: {
+      piece = new Knight(this);
+      break;
+    }
+    case PieceType::Bishop: {
+      piece = new Bishop(this);
+      break;
+    }
+    case PieceType::Rook: {
+      piece = new Rook(this);
+      break;
+    }
+    default: {
+      assert(type == PieceType::Queen);
+      piece = new Queen(this);
+      break;
+    }
+  }
+  pieces_.push_back(piece);
+  return piece;
 }
 
 bool Player::HasCastle(bool short_castle) const {
@@ -76,42 +93,6 @@ bool Player::HasCastle(bool short_castle) const {
   return king->HasCastle(short_castle);
 }
 
-Piece * Player::FindPiece(Movement * move) {
-  Piece * target_piece = nullptr;
-
-  assert(move->dest_file >= 0);
-  assert(move->dest_file < 8);
-  assert(move->dest_rank >= 0);
-  assert(move->dest_rank < 8);
-
-  for(auto const & piece : pieces_) {
-    if( *(move->piece_type) == typeid(*piece)) {
-      // check if piece can reach the destination square
-      if(piece->IsValidMove(move->dest_file, move->dest_rank)) {
-        // if can reach square, then filter by source square in case
-        // the information exists
-        if((move->source_file == -1 || piece->GetFile() == move->source_file) &&
-            (move->source_rank == -1 || piece->GetRank() == move->source_rank)) {
-          // just one piece shall satisfy all conditions
-          assert(target_piece == nullptr);
-          // this is the piece that needs to be moved!
-          target_piece = piece;
-          // fill information about source square
-          move->source_file = piece->GetFile();
-          move->source_rank = piece->GetRank();
-          move->piece = target_piece;
-          // at this point, it is possible to break the loop, but all pieces
-          // will be evaluated in order to guaranteed that just one satisfies
-          // all the conditions
-        }
-      }
-    }
-  }
-  // Piece found
-  assert(target_piece != nullptr);
-  return target_piece;
-}
-
 Piece * Player::FindPiece(std::string long_name, int file, int rank) const {
   Piece * target_piece = nullptr;
 
@@ -9,13 +9,13 @@
 
 #include <vector>
 #include "Common.h"
+#include "PackedMove.h"
 
 namespace acortes {
 namespace chess {
 
 class Piece;
 class Board;
-struct Movement;
 
 class Player {
 public:
@@ -23,7 +23,8 @@ public:
   void InitialSetup(Board *board);
   Color GetColor() const { return color_; }
   bool HasCastle(bool short_castle) const;
-  Movement * Move();
+  PackedMove Move();
+  Piece * GetPromotedPiece(PieceType type);
   virtual ~Player();
 
 protected:
@@ -31,8 +32,8 @@ protected:
   std::vector<Piece *> pieces_;
 
 private:
-  virtual Movement * GetPartialMoveInformation() = 0;
-  Piece * FindPiece(Movement * move);
+  // null move when the player has no more moves
+  virtual PackedMove GetNextMove() = 0;
   Piece * FindPiece(std::string long_name, int file = -1, int rank = -1) const;
 };
 
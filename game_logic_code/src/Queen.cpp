@@ -5,6 +5,7 @@
  */
 
 #include "Queen.h"
+#include "Board.h"
 #include <cassert>
 
 namespace acortes {
@@ -12,7 +13,7 @@ namespace chess {
 
 const std::string Queen::LongName = "Queen";
 
-Queen::Queen(Player * player) : Piece (player) {
+Queen::Queen(Player * player) : Piece(player, PieceType::Queen) {
 
 }
 
@@ -42,13 +43,16 @@ bool Queen::IsValidMove(int new_file, int new_rank) const {
     return false;
   } else if(file_movement == 0 && rank_movement !=0) {
     // forward/backward movement
-    return true;
+    // check no pieces in between
+    return board_->IsPathClear(file_, rank_, new_file, new_rank);
   } else if(file_movement != 0 && rank_movement ==0) {
     // left/right movement
-    return true;
+    // check no pieces in between
+    return board_->IsPathClear(file_, rank_, new_file, new_rank);
   } else if(file_movement == rank_movement) {
     // diagonal movement
-    return true;
+    // check no pieces in between
+    return board_->IsPathClear(file_, rank_, new_file, new_rank);
   }
   return false;
 }
@@ -13,7 +13,7 @@ namespace chess {
 
 const std::string Rook::LongName = "Rook";
 
-Rook::Rook(Player * player) : Piece(player) {
+Rook::Rook(Player * player) : Piece(player, PieceType::Rook) {
 
 }
 
@@ -44,25 +44,11 @@ bool Rook::IsValidMove(int new_file, int new_rank) const {
   } else if(file_movement == 0 && rank_movement !=0) {
     // forward/backward movement
     // check no pieces in between
-    int start_rank = (rank_ < new_rank) ? rank_ + 1 : new_rank + 1;
-    int end_rank = (rank_ < new_rank) ? new_rank : rank_;
-    for(int r = start_rank; r < end_rank; r++) {
-      if(board_->GetPiece(file_, r) != nullptr) {
-        return false;
-      }
-    }
-    return true;
+    return board_->IsPathClear(file_, rank_, new_file, new_rank);
   } else if(file_movement != 0 && rank_movement ==0) {
     // left/right movement
     // check no pieces in between
-    int start_file = (file_ < new_file) ? file_ + 1 : new_file + 1;
-    int end_file = (file_ < new_file) ? new_file : file_;
-    for(int f = start_file; f < end_file; f++) {
-      if(board_->GetPiece(f, rank_) != nullptr) {
-        return false;
-      }
-    }
-    return true;
+    return board_->IsPathClear(file_, rank_, new_file, new_rank);
   }
   return false;
 }
@@ -0,0 +1,180 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <cstring>
+#include "SAN.h"
+#include "Board.h"
+#include "MoveGenerator.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+const char PIECE_LETTERS[] = "PNBRQK";
+
+PieceType ToPieceType(char letter) {
+  const char * found = strchr(PIECE_LETTERS, letter);
+  if(letter == '\0' || found == nullptr) {
+    return PieceType::None;
+  }
+  return static_cast<PieceType>(found - PIECE_LETTERS);
+}
+
+}
+
+PackedMove SAN::Parse(const Board & board, const string & san) {
+  // check, mate and annotations are not needed to find the move
+  string text = san;
+  while(!text.empty() && strchr("+#!?", text.back()) != nullptr) {
+    text.pop_back();
+  }
+
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+
+  // castles, some files use zeros instead of the letter O
+  if(text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+    int flags = (text.size() == 3) ? PackedMove::SHORT_CASTLE : PackedMove::LONG_CASTLE;
+    for(const auto & move : moves) {
+      if(move.GetFlags() == flags) {
+        return move;
+      }
+    }
+    return PackedMove();
+  }
+
+  // promotion, e8=Q or e8Q
+  PieceType promotion = PieceType::None;
+  if(text.size() > 2 && ToPieceType(text.back()) != PieceType::None) {
+    promotion = ToPieceType(text.back());
+    text.pop_back();
+    if(text.back() == '=') {
+      text.pop_back();
+    }
+  }
+
+  // piece letter, pawns have none
+  PieceType type = PieceType::Pawn;
+  size_t i = 0;
+  if(!text.empty() && isupper(text[0])) {
+    type = ToPieceType(text[0]);
+    i++;
+  }
+
+  // what is left is the optional disambiguation and the destination
+  int file = -1;
+  int rank = -1;
+  string squares;
+  for(; i < text.size(); ++i) {
+    if(text[i] != 'x' && text[i] != '-' && text[i] != ':') {
+      squares += text[i];
+    }
+  }
+  if(squares.size() < 2 || squares.size() > 4 || type == PieceType::None) {
+    return PackedMove();
+  }
+  char dest_file = squares[squares.size() - 2];
+  char dest_rank = squares[squares.size() - 1];
+  if(dest_file < 'a' || dest_file > 'h' || dest_rank < '1' || dest_rank > '8') {
+    return PackedMove();
+  }
+  int to = GetSquare(GetFile(dest_file), GetRank(dest_rank));
+  for(size_t j = 0; j + 2 < squares.size(); ++j) {
+    if(squares[j] >= 'a' && squares[j] <= 'h') {
+      file = GetFile(squares[j]);
+    } else if(squares[j] >= '1' && squares[j] <= '8') {
+      rank = GetRank(squares[j]);
+    } else {
+      return PackedMove();
+    }
+  }
+
+  // just one legal move shall satisfy all conditions
+  PackedMove found;
+  for(const auto & move : moves) {
+    if(move.GetTo() == to &&
+       board.GetPieceType(move.GetFrom()) == type &&
+       (file == -1 || SquareFile(move.GetFrom()) == file) &&
+       (rank == -1 || SquareRank(move.GetFrom()) == rank) &&
+       (move.IsPromotion() ? move.GetPromotion() == promotion :
+                             promotion == PieceType::None)) {
+      if(!found.IsNull()) {
+        return PackedMove();
+      }
+      found = move;
+    }
+  }
+  return found;
+}
+
+string SAN::Write(const Board & board, PackedMove move) {
+  string san;
+  const int from = move.GetFrom();
+  const int to = move.GetTo();
+  const PieceType type = board.GetPieceType(from);
+
+  if(move.IsCastle()) {
+    san = (move.GetFlags() == PackedMove::SHORT_CASTLE) ? "O-O" : "O-O-O";
+  } else {
+    if(type == PieceType::Pawn) {
+      if(move.IsCapture()) {
+        san += GetFile(SquareFile(from));
+      }
+    } else {
+      san += PIECE_LETTERS[ToIndex(type)];
+
+      // other pieces of the same kind reaching the same square
+      MoveList moves;
+      MoveGenerator::GenerateLegalMoves(board, moves);
+      bool ambiguous = false;
+      bool same_file = false;
+      bool same_rank = false;
+      for(const auto & other : moves) {
+        if(other.GetTo() == to && other.GetFrom() != from &&
+           board.GetPieceType(other.GetFrom()) == type) {
+          ambiguous = true;
+          same_file = same_file || SquareFile(other.GetFrom()) == SquareFile(from);
+          same_rank = same_rank || SquareRank(other.GetFrom()) == SquareRank(from);
+        }
+      }
+      if(ambiguous && (!same_file || same_rank)) {
+        san += GetFile(SquareFile(from));
+      }
+      if(ambiguous && same_file) {
+        san += GetRank(SquareRank(from));
+      }
+    }
+
+    if(move.IsCapture()) {
+      san += 'x';
+    }
+    san += GetFile(SquareFile(to));
+    san += GetRank(SquareRank(to));
+    if(move.IsPromotion()) {
+      san += '=';
+      san += PIECE_LETTERS[ToIndex(move.GetPromotion())];
+    }
+  }
+
+  // check and mate are found making the move on a copy
+  Board copy(board);
+  copy.DetachPieces();
+  MoveUndo undo;
+  copy.MakeMove(move, undo);
+  if(MoveGenerator::IsInCheck(copy)) {
+    MoveList replies;
+    MoveGenerator::GenerateLegalMoves(copy, replies);
+    san += replies.Empty() ? '#' : '+';
+  }
+
+  return san;
+}
+
+}
+}
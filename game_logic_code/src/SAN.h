@@ -0,0 +1,31 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef SAN_H_
+#define SAN_H_
+
+#include <string>
+#include "PackedMove.h"
+
+namespace acortes {
+namespace chess {
+
+class Board;
+
+// Standard algebraic notation, as used in PGN files (Nf3, exd5, e8=Q,
+// O-O). A SAN move only makes sense in a position, so both directions
+// go through the legal moves of the board.
+class SAN {
+public:
+  // null move if the text is not a legal move in the position
+  static PackedMove Parse(const Board & board, const std::string & san);
+  static std::string Write(const Board & board, PackedMove move);
+};
+
+}
+}
+
+#endif /* SAN_H_ */
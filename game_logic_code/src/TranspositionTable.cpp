@@ -0,0 +1,170 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <sys/mman.h>
+#include <algorithm>
+#include <climits>
+#include <new>
+#include "TranspositionTable.h"
+
+using namespace std;
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+const int GENERATIONS = 64;
+
+// data of an entry: the move in bits 0-15, the score in bits 16-47, the
+// depth in bits 48-55, the bound in bits 56-57 and the generation in bits
+// 58-63. An empty entry is all zeros, with no bound.
+uint64_t Pack(PackedMove move, int score, int depth, int bound, int generation) {
+  return static_cast<uint64_t>(move.GetData()) |
+         (static_cast<uint64_t>(static_cast<uint32_t>(score)) << 16) |
+         (static_cast<uint64_t>(min(max(depth, 0), 255)) << 48) |
+         (static_cast<uint64_t>(bound) << 56) |
+         (static_cast<uint64_t>(generation) << 58);
+}
+
+PackedMove GetMove(uint64_t data) {
+  return PackedMove(data & 0x3f, (data >> 6) & 0x3f, (data >> 12) & 0xf);
+}
+
+int GetScore(uint64_t data) {
+  return static_cast<int32_t>(static_cast<uint32_t>(data >> 16));
+}
+
+int GetDepth(uint64_t data) {
+  return (data >> 48) & 0xff;
+}
+
+int GetBound(uint64_t data) {
+  return (data >> 56) & 3;
+}
+
+int GetGeneration(uint64_t data) {
+  return data >> 58;
+}
+
+}
+
+const size_t TranspositionTable::BUCKET_SIZE;
+
+TranspositionTable::TranspositionTable(size_t size_mb, bool huge_pages) :
+  memory_(nullptr), memory_size_(0), buckets_(nullptr), num_buckets_(1),
+  generation_(0) {
+  while(num_buckets_ * 2 * sizeof(Bucket) <= size_mb * 1024 * 1024) {
+    num_buckets_ *= 2;
+  }
+
+  // mapped memory starts zeroed, which are empty entries
+  size_t alignment = huge_pages ? HUGE_PAGE_SIZE : 0;
+  while(true) {
+    memory_size_ = num_buckets_ * sizeof(Bucket) + alignment;
+    memory_ = mmap(nullptr, memory_size_, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory_ != MAP_FAILED || num_buckets_ == 1) {
+      break;
+    }
+    num_buckets_ /= 2;
+  }
+  if(memory_ == MAP_FAILED) {
+    throw bad_alloc();
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(memory_);
+  if(alignment > 0) {
+    start = (start + alignment - 1) & ~(alignment - 1);
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void *>(start), num_buckets_ * sizeof(Bucket),
+        MADV_HUGEPAGE);
+#endif
+  }
+  buckets_ = new(reinterpret_cast<void *>(start)) Bucket[num_buckets_];
+}
+
+TranspositionTable::~TranspositionTable() {
+  munmap(memory_, memory_size_);
+}
+
+void TranspositionTable::Clear() {
+  for(size_t i = 0; i < num_buckets_; ++i) {
+    for(auto & slot : buckets_[i].slots) {
+      slot.key.store(0, memory_order_relaxed);
+      slot.data.store(0, memory_order_relaxed);
+    }
+  }
+  generation_.store(0, memory_order_relaxed);
+}
+
+void TranspositionTable::NewSearch() {
+  generation_.fetch_add(1, memory_order_relaxed);
+}
+
+bool TranspositionTable::Probe(uint64_t key, Entry & entry) const {
+  const Bucket & bucket = buckets_[key & (num_buckets_ - 1)];
+  for(const auto & slot : bucket.slots) {
+    uint64_t data = slot.data.load(memory_order_relaxed);
+    if((slot.key.load(memory_order_relaxed) ^ data) == key &&
+       GetBound(data) != NO_BOUND) {
+      entry.move = GetMove(data);
+      entry.score = GetScore(data);
+      entry.depth = GetDepth(data);
+      entry.bound = static_cast<Bound>(GetBound(data));
+      return true;
+    }
+  }
+  return false;
+}
+
+void TranspositionTable::Store(uint64_t key, PackedMove move, int score, int depth,
+    Bound bound) {
+  Bucket & bucket = buckets_[key & (num_buckets_ - 1)];
+  int generation = generation_.load(memory_order_relaxed) % GENERATIONS;
+  Slot * replaced = nullptr;
+  int lowest_value = INT_MAX;
+  for(auto & slot : bucket.slots) {
+    uint64_t data = slot.data.load(memory_order_relaxed);
+    if((slot.key.load(memory_order_relaxed) ^ data) == key &&
+       GetBound(data) != NO_BOUND) {
+      replaced = &slot;
+      if(move.IsNull()) {
+        move = GetMove(data);
+      }
+      break;
+    }
+    // empty entries first, then the oldest and shallowest
+    int age = (generation - GetGeneration(data) + GENERATIONS) % GENERATIONS;
+    int value = (GetBound(data) == NO_BOUND) ? INT_MIN : GetDepth(data) - 8 * age;
+    if(value < lowest_value) {
+      lowest_value = value;
+      replaced = &slot;
+    }
+  }
+
+  uint64_t data = Pack(move, score, depth, bound, generation);
+  replaced->key.store(key ^ data, memory_order_relaxed);
+  replaced->data.store(data, memory_order_relaxed);
+}
+
+int TranspositionTable::GetHashfull() const {
+  size_t num_buckets = min(num_buckets_, static_cast<size_t>(1000 / BUCKET_SIZE));
+  int generation = generation_.load(memory_order_relaxed) % GENERATIONS;
+  int num_used = 0;
+  for(size_t i = 0; i < num_buckets; ++i) {
+    for(const auto & slot : buckets_[i].slots) {
+      uint64_t data = slot.data.load(memory_order_relaxed);
+      num_used += (GetBound(data) != NO_BOUND &&
+                   GetGeneration(data) == generation) ? 1 : 0;
+    }
+  }
+  return num_used * 1000 / static_cast<int>(num_buckets * BUCKET_SIZE);
+}
+
+}
+}
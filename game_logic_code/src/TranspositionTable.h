@@ -0,0 +1,82 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef TRANSPOSITIONTABLE_H_
+#define TRANSPOSITIONTABLE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "PackedMove.h"
+
+namespace acortes {
+namespace chess {
+
+// Results of searched positions, found by their Zobrist key. Entries are
+// grouped in buckets of one cache line, a position can be in any entry
+// of the bucket of its key. Threads read and write the table at the same
+// time without locks: each entry keeps its key xor'ed with its data, so
+// an entry torn by two threads writing it at once does not match any key
+// and is ignored, like in Perft.
+// Entries of older searches are replaced first, then the shallowest ones.
+class TranspositionTable {
+public:
+  enum Bound { NO_BOUND = 0, UPPER_BOUND = 1, LOWER_BOUND = 2, EXACT = 3 };
+
+  // what is known of a position
+  struct Entry {
+    PackedMove move;
+    int score;
+    int depth;
+    Bound bound;
+  };
+
+  static const size_t BUCKET_SIZE = 4;
+
+  // the biggest power of two number of buckets that fits in size_mb,
+  // smaller if there is not memory for it. With huge_pages the kernel
+  // is asked to back the table with huge pages, which saves TLB misses
+  // on big tables.
+  explicit TranspositionTable(size_t size_mb, bool huge_pages = false);
+  ~TranspositionTable();
+  void Clear();
+  // entries of previous searches become the first to be replaced. Only
+  // the owner of the table calls it, once per search, engines sharing
+  // the table would otherwise age its entries once each.
+  void NewSearch();
+  bool Probe(uint64_t key, Entry & entry) const;
+  // the move of the entry is kept when the new one has none
+  void Store(uint64_t key, PackedMove move, int score, int depth, Bound bound);
+  // permill of the entries in use by the current search, from a sample
+  int GetHashfull() const;
+  size_t GetNumEntries() const { return num_buckets_ * BUCKET_SIZE; }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> key;
+    std::atomic<uint64_t> data;
+  };
+  struct alignas(64) Bucket {
+    Slot slots[BUCKET_SIZE];
+  };
+
+  // the mapping may start before the first bucket to align it
+  void * memory_;
+  size_t memory_size_;
+  Bucket * buckets_;
+  size_t num_buckets_;
+  // of the current search in its lower 6 bits, it only grows so it can
+  // be increased while engines sharing the table store
+  std::atomic<uint32_t> generation_;
+
+  TranspositionTable(const TranspositionTable &) = delete;
+  TranspositionTable & operator=(const TranspositionTable &) = delete;
+};
+
+}
+}
+
+#endif /* TRANSPOSITIONTABLE_H_ */
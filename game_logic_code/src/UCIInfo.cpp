@@ -0,0 +1,187 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "UCIInfo.h"
+#include "Board.h"
+#include "MoveGenerator.h"
+
+namespace acortes {
+namespace chess {
+
+namespace {
+
+// next word of the line, empty at the end
+TextSpan NextToken(const char *& cursor, const char * end) {
+  while(cursor < end && *cursor == ' ') {
+    cursor++;
+  }
+  const char * start = cursor;
+  while(cursor < end && *cursor != ' ') {
+    cursor++;
+  }
+  return TextSpan(start, cursor - start);
+}
+
+// a number with an optional sign, 0 if it is not a number
+long ToNumber(const TextSpan & token) {
+  size_t i = (token.size > 0 && token.data[0] == '-') ? 1 : 0;
+  long value = 0;
+  for(size_t j = i; j < token.size; ++j) {
+    if(token.data[j] < '0' || token.data[j] > '9') {
+      return 0;
+    }
+    value = value * 10 + (token.data[j] - '0');
+  }
+  return (i == 1) ? -value : value;
+}
+
+bool IsSquare(const char * text) {
+  return text[0] >= 'a' && text[0] <= 'h' && text[1] >= '1' && text[1] <= '8';
+}
+
+// keywords of an info line in the UCI protocol
+const char * FIELDS[] = {"depth", "seldepth", "time", "nodes", "multipv",
+    "score", "currmove", "currmovenumber", "hashfull", "nps", "tbhits",
+    "sbhits", "cpuload", "pv", "string", "refutation", "currline"};
+
+bool IsKeyword(const TextSpan & token) {
+  for(const char * field : FIELDS) {
+    if(token == field) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+const size_t UCIInfo::MAX_PV_LENGTH;
+
+void UCIInfo::Clear() {
+  depth = 0;
+  seldepth = 0;
+  multipv = 0;
+  time_ms = 0;
+  nodes = 0;
+  nps = 0;
+  hashfull = 0;
+  has_score = false;
+  is_mate = false;
+  score = 0;
+  bound = Bound::Exact;
+  pv_length = 0;
+}
+
+bool UCIInfo::Parse(const TextSpan & line) {
+  Clear();
+  const char * cursor = line.data;
+  const char * end = line.data + line.size;
+  if(!(NextToken(cursor, end) == "info")) {
+    return false;
+  }
+
+  TextSpan token = NextToken(cursor, end);
+  while(!token.Empty()) {
+    if(token == "depth") {
+      depth = ToNumber(NextToken(cursor, end));
+    } else if(token == "seldepth") {
+      seldepth = ToNumber(NextToken(cursor, end));
+    } else if(token == "multipv") {
+      multipv = ToNumber(NextToken(cursor, end));
+    } else if(token == "time") {
+      time_ms = ToNumber(NextToken(cursor, end));
+    } else if(token == "nodes") {
+      nodes = ToNumber(NextToken(cursor, end));
+    } else if(token == "nps") {
+      nps = ToNumber(NextToken(cursor, end));
+    } else if(token == "hashfull") {
+      hashfull = ToNumber(NextToken(cursor, end));
+    } else if(token == "score") {
+      // cp or mate, then the value and maybe a bound
+      TextSpan type = NextToken(cursor, end);
+      TextSpan value = NextToken(cursor, end);
+      has_score = (type == "cp" || type == "mate") && !value.Empty();
+      is_mate = (type == "mate");
+      score = ToNumber(value);
+      const char * next = cursor;
+      TextSpan bound_token = NextToken(next, end);
+      if(bound_token == "lowerbound" || bound_token == "upperbound") {
+        bound = (bound_token == "lowerbound") ? Bound::Lower : Bound::Upper;
+        cursor = next;
+      }
+    } else if(token == "pv") {
+      // moves until the next keyword
+      const char * next = cursor;
+      TextSpan move = NextToken(next, end);
+      while(!move.Empty() && !IsKeyword(move)) {
+        PackedMove packed = ParseMove(move);
+        if(!packed.IsNull() && pv_length < MAX_PV_LENGTH) {
+          pv[pv_length++] = packed;
+        }
+        cursor = next;
+        move = NextToken(next, end);
+      }
+    } else if(token == "string") {
+      // free text until the end of the line
+      break;
+    } else if(IsKeyword(token)) {
+      // fields not kept, their value is skipped. Unknown words are
+      // skipped one at a time.
+      NextToken(cursor, end);
+    }
+    token = NextToken(cursor, end);
+  }
+  return true;
+}
+
+bool UCIInfo::ResolvePV(const Board & board) {
+  Board copy(board);
+  copy.DetachPieces();
+  MoveUndo undo;
+  for(size_t i = 0; i < pv_length; ++i) {
+    MoveList moves;
+    MoveGenerator::GenerateLegalMoves(copy, moves);
+    PackedMove legal;
+    for(const auto & move : moves) {
+      if(move.GetFrom() == pv[i].GetFrom() && move.GetTo() == pv[i].GetTo() &&
+         move.IsPromotion() == pv[i].IsPromotion() &&
+         (!move.IsPromotion() || move.GetPromotion() == pv[i].GetPromotion())) {
+        legal = move;
+        break;
+      }
+    }
+    if(legal.IsNull()) {
+      pv_length = i;
+      return false;
+    }
+    pv[i] = legal;
+    copy.MakeMove(legal, undo);
+  }
+  return true;
+}
+
+PackedMove UCIInfo::ParseMove(const TextSpan & text) {
+  static const char promotions[] = "nbrq";
+  if((text.size != 4 && text.size != 5) || !IsSquare(text.data) ||
+     !IsSquare(text.data + 2)) {
+    return PackedMove();
+  }
+  int from = GetSquare(GetFile(text.data[0]), GetRank(text.data[1]));
+  int to = GetSquare(GetFile(text.data[2]), GetRank(text.data[3]));
+  int flags = PackedMove::QUIET;
+  if(text.size == 5) {
+    const char * promotion = static_cast<const char *>(
+        memchr(promotions, text.data[4], 4));
+    if(promotion == nullptr) {
+      return PackedMove();
+    }
+    flags = PackedMove::KNIGHT_PROMOTION + (promotion - promotions);
+  }
+  return PackedMove(from, to, flags);
+}
+
+}
+}
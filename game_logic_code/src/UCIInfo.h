@@ -0,0 +1,63 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef UCIINFO_H_
+#define UCIINFO_H_
+
+#include <cstdint>
+#include "Common.h"
+#include "PackedMove.h"
+
+namespace acortes {
+namespace chess {
+
+class Board;
+
+// Fields of an "info" line sent by an engine during a search. The line
+// is read in place and nothing is allocated, so it can be done for every
+// line the engine sends. Fields missing from the line are 0.
+struct UCIInfo {
+  enum class Bound { Exact, Lower, Upper };
+
+  // longer principal variations are cut
+  static const size_t MAX_PV_LENGTH = 32;
+
+  int depth;
+  int seldepth;
+  int multipv;
+  long time_ms;
+  uint64_t nodes;
+  uint64_t nps;
+  // permill of the hash in use
+  int hashfull;
+  // score from the side to move, in centipawns or in moves to mate,
+  // negative when the side to move is mated
+  bool has_score;
+  bool is_mate;
+  long score;
+  Bound bound;
+  // moves only have their squares and the promotion, see ResolvePV()
+  PackedMove pv[MAX_PV_LENGTH];
+  size_t pv_length;
+
+  UCIInfo() { Clear(); }
+  void Clear();
+  // false if it is not an info line
+  bool Parse(const TextSpan & line);
+  // replaces the moves of the pv with the legal moves of the position,
+  // with all their flags. The pv is cut at the first move that is not
+  // legal, false if there is one.
+  bool ResolvePV(const Board & board);
+
+  // a move in UCI notation, like e2e4 or e7e8q, without its flags. A
+  // null move if the text is not a move.
+  static PackedMove ParseMove(const TextSpan & text);
+};
+
+}
+}
+
+#endif /* UCIINFO_H_ */
@@ -0,0 +1,61 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "Zobrist.h"
+
+namespace acortes {
+namespace chess {
+
+uint64_t Zobrist::pieces[NUM_COLORS][NUM_PIECE_TYPES][NUM_SQUARES];
+uint64_t Zobrist::castling[ALL_CASTLING + 1];
+uint64_t Zobrist::en_passant_file[8];
+uint64_t Zobrist::dark_to_move;
+
+namespace {
+
+// splitmix64, good enough and fully deterministic
+uint64_t NextRandom(uint64_t & state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+struct ZobristKeys {
+  ZobristKeys() {
+    uint64_t state = 0x0123456789abcdefULL;
+    for(auto & color : Zobrist::pieces) {
+      for(auto & type : color) {
+        for(auto & square : type) {
+          square = NextRandom(state);
+        }
+      }
+    }
+    // a combination of rights gets the xor of the keys of each right,
+    // so rights can be lost one at a time
+    uint64_t rights[4];
+    for(auto & right : rights) {
+      right = NextRandom(state);
+    }
+    for(int i = 0; i <= ALL_CASTLING; ++i) {
+      Zobrist::castling[i] = 0;
+      for(int bit = 0; bit < 4; ++bit) {
+        if(i & (1 << bit)) {
+          Zobrist::castling[i] ^= rights[bit];
+        }
+      }
+    }
+    for(auto & file : Zobrist::en_passant_file) {
+      file = NextRandom(state);
+    }
+    Zobrist::dark_to_move = NextRandom(state);
+  }
+} keys_;
+
+}
+
+}
+}
@@ -0,0 +1,38 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#ifndef ZOBRIST_H_
+#define ZOBRIST_H_
+
+#include <cstdint>
+#include "Common.h"
+#include "Bitboard.h"
+
+namespace acortes {
+namespace chess {
+
+// Random keys xor'ed together to identify a position. The keys are
+// generated from a fixed seed, so a position has the same key in every
+// run and keys can be stored on disk.
+struct Zobrist {
+  static uint64_t pieces[NUM_COLORS][NUM_PIECE_TYPES][NUM_SQUARES];
+  static uint64_t castling[ALL_CASTLING + 1];
+  static uint64_t en_passant_file[8];
+  static uint64_t dark_to_move;
+
+  static uint64_t Piece(Color color, PieceType type, int square) {
+    return pieces[ToIndex(color)][ToIndex(type)][square];
+  }
+  // en passant only depends on the file of the target square
+  static uint64_t EnPassant(int square) {
+    return (square == -1) ? 0 : en_passant_file[SquareFile(square)];
+  }
+};
+
+}
+}
+
+#endif /* ZOBRIST_H_ */
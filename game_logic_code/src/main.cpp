@@ -1,59 +1,181 @@
 #include <ncurses.h>
 #include <getopt.h>
-#include <tuple>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "AnalysisCache.h"
+#include "AnalysisCheckpoint.h"
+#include "AnalysisWriter.h"
+#include "EnginePool.h"
 #include "Game.h"
 #include "Player.h"
 #include "PGNPlayer.h"
 #include "Board.h"
+#include "PGNDatabase.h"
 #include "PGNReader.h"
 #include "ChessEngineInterface.h"
 
 using namespace std;
 using namespace acortes::chess;
 
-tuple<string, string,bool,bool,long,long> ParseArguments(int argc, char* argv[]);
+// options of the headless analysis
+struct AnalyzerArguments {
+  string engine;
+  vector<string> pgnfiles;
+  bool analyze_light;
+  bool analyze_dark;
+  SearchLimits limits;
+  long blunder_threshold;
+  EngineOptions options;
+  int num_engines;
+  // standard output if empty
+  string output;
+  AnalysisWriter::Format format;
+  bool blunders_only;
+  // empty for no checkpoints
+  string checkpoint;
+  size_t checkpoint_interval;
+  bool resume;
+  // empty for no cache of results
+  string cache;
+  size_t cache_mb;
+};
+
+AnalyzerArguments ParseArguments(int argc, char* argv[]);
 string PrintUsage();
 
-int GameAnalysis(int argc, char* argv[]) {
-  string engine_path;
-  string pgnfile;
-  bool analize_light;
-  bool analize_dark;
-  long time_per_move;
-  long blunder_threshold;
-  tie(engine_path, pgnfile, analize_light, analize_dark, time_per_move, blunder_threshold) =
-      ParseArguments(argc, argv);
+// analysis of all the games of the PGN files, written as they are done
+// in the order of the files. A few games more than engines are kept in
+// flight, so the next games are read while the engines search. With a
+// checkpoint the progress is saved every checkpoint_interval games, and
+// a resumed run goes on from the last one.
+int AnalyzeGames(int argc, char* argv[]) {
+  AnalyzerArguments arguments = ParseArguments(argc, argv);
+
+  AnalysisCheckpoint checkpoint(arguments.checkpoint);
+  bool is_resumed = arguments.resume && checkpoint.Load();
+  if(is_resumed) {
+    // an output shorter than the checkpoint lost records the checkpoint
+    // counts, it was replaced or not written to disk
+    struct stat output_stat;
+    if(stat(arguments.output.c_str(), &output_stat) != 0 ||
+       static_cast<uint64_t>(output_stat.st_size) < checkpoint.GetOutputSize()) {
+      cerr << "Cannot resume, " << arguments.output << " is shorter than "
+           << arguments.checkpoint << " says" << endl;
+      return EXIT_FAILURE;
+    }
+    // records after the checkpoint are written again
+    if(truncate(arguments.output.c_str(), checkpoint.GetOutputSize()) != 0) {
+      cerr << "Cannot resume " << arguments.output << endl;
+      return EXIT_FAILURE;
+    }
+  }
 
-  Board *board = new Board(8,8);
-  PGNReader pgn(pgnfile);
-  PGNPlayer *player1 = new PGNPlayer(Color::Light, &pgn);
-  PGNPlayer *player2 = new PGNPlayer(Color::Dark, &pgn);
-  Game game(board, player1, player2);
-  game.InitialSetup();
+  ofstream file;
+  if(!arguments.output.empty()) {
+    file.open(arguments.output, is_resumed ? ios::app : ios::trunc);
+    if(!file) {
+      cerr << "Cannot open " << arguments.output << endl;
+      return EXIT_FAILURE;
+    }
+  }
+  AnalysisWriter writer(arguments.output.empty() ? cout : file, arguments.format,
+      arguments.blunders_only);
+  if(is_resumed && checkpoint.GetOutputSize() > 0) {
+    writer.SkipHeader();
+  }
+  auto save_checkpoint = [&]() {
+    writer.Flush();
+    file.seekp(0, ios::end);
+    checkpoint.SetOutputSize(file.tellp());
+    if(!AnalysisCheckpoint::SyncFile(arguments.output) || !checkpoint.Save()) {
+      cerr << "Cannot save " << arguments.checkpoint << endl;
+    }
+  };
 
-  ChessEngineInterface engine(engine_path, false);
-  engine.Analyze(game, analize_light, analize_dark, time_per_move, blunder_threshold);
+  // positions searched by a previous run are not searched again
+  unique_ptr<AnalysisCache> cache;
+  if(!arguments.cache.empty()) {
+    cache.reset(new AnalysisCache(arguments.cache, arguments.cache_mb));
+    if(!cache->IsOpen()) {
+      cerr << "Cannot open " << arguments.cache << endl;
+      return EXIT_FAILURE;
+    }
+  }
 
-  delete player1;
-  delete player2;
-  delete board;
+  EnginePool pool(arguments.engine, arguments.num_engines, false, cache.get(),
+      arguments.options);
+  deque<pair<AnalyzedGame, future<GameAnalysis>>> pending;
+  size_t max_pending = 2 * arguments.num_engines;
+  size_t num_games = 0;
+  size_t num_written = 0;
+  size_t num_records = 0;
+  size_t num_failed = 0;
+  auto write_next = [&]() {
+    GameAnalysis analysis = pending.front().second.get();
+    for(const auto & move : analysis.moves) {
+      num_failed += (!move.best.is_valid || !move.played.is_valid) ? 1 : 0;
+    }
+    const AnalyzedGame & game = pending.front().first;
+    num_records += writer.Write(game, analysis);
+    num_written++;
+    if(!arguments.checkpoint.empty()) {
+      checkpoint.SetNumGamesDone(game.file, game.index + 1);
+      if(num_written % arguments.checkpoint_interval == 0) {
+        save_checkpoint();
+      }
+    }
+    pending.pop_front();
+  };
 
-  return 0;
-}
+  bool has_errors = false;
+  for(const auto & pgnfile : arguments.pgnfiles) {
+    PGNDatabase database(pgnfile);
+    if(!database.IsOpen()) {
+      cerr << "Cannot open " << pgnfile << endl;
+      has_errors = true;
+      continue;
+    }
+    size_t index = 0;
+    size_t num_done = checkpoint.GetNumGamesDone(pgnfile);
+    for(const auto & game : database) {
+      if(index < num_done) {
+        index++;
+        continue;
+      }
+      AnalyzedGame info = {pgnfile, index++, game.GetTag("White").ToString(),
+                           game.GetTag("Black").ToString()};
+      pending.push_back(make_pair(info, pool.Submit(PGNReader(game),
+          arguments.analyze_light, arguments.analyze_dark, arguments.limits,
+          arguments.blunder_threshold)));
+      num_games++;
+      while(pending.size() >= max_pending) {
+        write_next();
+      }
+    }
+  }
+  while(!pending.empty()) {
+    write_next();
+  }
+  if(!arguments.checkpoint.empty()) {
+    save_checkpoint();
+  }
+  writer.Flush();
 
-struct ChessGameState {
-  struct ChessGameState * next;
-  struct ChessGameState * prev;
-  struct ChessGameState * alternatives;
-  string move;
-  string FEN;
-
-  ChessGameState() :
-    next(nullptr), prev(nullptr), alternatives(nullptr) {}
-  ChessGameState(string move, string FEN) :
-    next(nullptr), prev(nullptr), alternatives(nullptr),
-    move(move), FEN(FEN) {}
-};
+  cerr << "Games: " << num_games << endl;
+  cerr << "Records: " << num_records << endl;
+  if(num_failed > 0) {
+    cerr << "Moves the engine failed to analyze: " << num_failed << endl;
+  }
+  return (has_errors || num_failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
 void PrintFEN(string FEN) {
   char space = ' ';
@@ -96,29 +218,29 @@ int DisplayGame(int argc, char* argv[]) {
   Game game(board, player1, player2);
   game.InitialSetup();
 
-  ChessGameState * start_game = new ChessGameState;
-  ChessGameState * last_move = start_game;
-
   while(game.Move()) {
-    last_move->next = new ChessGameState(game.GetLastMove(), game.FEN());
-    last_move->next->prev = last_move;
-    last_move = last_move->next;
   }
 
-  last_move = start_game->next;
+  // moves taken back, so they can be made again
+  vector<PackedMove> next_moves;
+  while(game.GetNumMoves() > 1) {
+    next_moves.push_back(game.UnmakeMove());
+  }
+
   while(tmp != 'x') {
     clear();
-    PrintFEN(last_move->FEN);
+    PrintFEN(game.FEN());
     refresh();
     tmp = getch();
     if(tmp == KEY_LEFT) {
-      if(last_move->prev != start_game) {
-        last_move = last_move->prev;
+      if(game.GetNumMoves() > 1) {
+        next_moves.push_back(game.UnmakeMove());
       }
     }
     else if (tmp == KEY_RIGHT) {
-      if(last_move->next) {
-        last_move = last_move->next;
+      if(!next_moves.empty()) {
+        game.MakeMove(next_moves.back());
+        next_moves.pop_back();
       }
     }
   }
@@ -131,6 +253,11 @@ int DisplayGame(int argc, char* argv[]) {
 }
 
 int main(int argc, char* argv[]) {
+  // a single PGN file is displayed, anything else is a headless analysis
+  if(argc != 2 || argv[1][0] == '-') {
+    return AnalyzeGames(argc, argv);
+  }
+
   // ncurses initialization
   initscr();
   cbreak();
@@ -147,14 +274,19 @@ int main(int argc, char* argv[]) {
   endwin();
 }
 
-tuple<string, string, bool, bool, long, long> ParseArguments(int argc, char * argv[]) {
-
-  string engine = "";
-  string pgnfile = "";
-  bool analize_light = false;
-  bool analize_dark = false;
-  long time_per_move = 1;
-  long blunder_threshold = 50;
+AnalyzerArguments ParseArguments(int argc, char * argv[]) {
+  AnalyzerArguments arguments;
+  arguments.analyze_light = false;
+  arguments.analyze_dark = false;
+  arguments.blunder_threshold = 50;
+  arguments.num_engines = 1;
+  arguments.format = AnalysisWriter::Format::CSV;
+  arguments.blunders_only = false;
+  arguments.checkpoint_interval = 100;
+  arguments.resume = false;
+  arguments.cache_mb = 64;
+  SearchLimits & limits = arguments.limits;
+  EngineOptions & options = arguments.options;
 
   static struct option long_options[] = {
       {"engine", required_argument, 0,'e'},
@@ -162,66 +294,221 @@ tuple<string, string, bool, bool, long, long> ParseArguments(int argc, char * ar
       {"analyze_light", no_argument,0,'l'},
       {"analyze_dark", no_argument, 0, 'd'},
       {"time_per_move", required_argument, 0, 't'},
-      {"blunder_threshold", required_argument,0,'b'}
+      {"movetime", required_argument, 0, 'M'},
+      {"depth", required_argument, 0, 'D'},
+      {"nodes", required_argument, 0, 'N'},
+      {"stable", required_argument, 0, 'S'},
+      {"stable_margin", required_argument, 0, 'g'},
+      {"blunder_threshold", required_argument,0,'b'},
+      {"hash", required_argument, 0, 'H'},
+      {"threads", required_argument, 0, 'T'},
+      {"multipv", required_argument, 0, 'm'},
+      {"syzygy_path", required_argument, 0, 's'},
+      {"option", required_argument, 0, 'o'},
+      {"search_timeout", required_argument, 0, 'W'},
+      {"engines", required_argument, 0, 'n'},
+      {"output", required_argument, 0, 'O'},
+      {"format", required_argument, 0, 'F'},
+      {"blunders_only", no_argument, 0, 'B'},
+      {"checkpoint", required_argument, 0, 'C'},
+      {"checkpoint_interval", required_argument, 0, 'I'},
+      {"resume", no_argument, 0, 'R'},
+      {"cache", required_argument, 0, 'c'},
+      {"cache_size", required_argument, 0, 'z'},
+      {0, 0, 0, 0}
   };
 
   int opt=0;
   int long_index = 0;
 
-  while((opt = getopt_long(argc, argv, "e:f:t:b:a:",
+  while((opt = getopt_long(argc, argv, "e:f:t:b:a:H:T:m:s:o:M:D:N:S:g:W:n:O:F:BC:I:Rc:z:",
           long_options, &long_index)) != -1) {
     switch(opt) {
 
       case 'e': {
-        engine = string(optarg);
+        arguments.engine = string(optarg);
         break;
       }
 
       case 'f': {
-        pgnfile = string(optarg);
+        arguments.pgnfiles.push_back(string(optarg));
         break;
       }
 
       case 'l': {
-        analize_light = true;
+        arguments.analyze_light = true;
         break;
       }
 
       case 'd': {
-        analize_dark = true;
+        arguments.analyze_dark = true;
         break;
       }
 
       case 't': {
-        time_per_move = atol(optarg);
+        limits.movetime_ms = atol(optarg) * 1000;
+        break;
+      }
+
+      case 'M': {
+        limits.movetime_ms = atol(optarg);
+        break;
+      }
+
+      case 'D': {
+        limits.depth = atoi(optarg);
+        break;
+      }
+
+      case 'N': {
+        limits.nodes = atol(optarg);
+        break;
+      }
+
+      case 'S': {
+        limits.stable_iterations = atoi(optarg);
+        break;
+      }
+
+      case 'g': {
+        limits.stable_margin = atoi(optarg);
         break;
       }
 
       case 'b': {
-        blunder_threshold = atol(optarg);
+        arguments.blunder_threshold = atol(optarg);
+        break;
+      }
+
+      case 'H': {
+        options.hash_mb = atoi(optarg);
+        break;
+      }
+
+      case 'T': {
+        options.threads = atoi(optarg);
+        break;
+      }
+
+      case 'm': {
+        options.multipv = atoi(optarg);
+        break;
+      }
+
+      case 's': {
+        options.syzygy_path = string(optarg);
+        break;
+      }
+
+      case 'o': {
+        // name=value, the name can have spaces
+        string option(optarg);
+        size_t equal = option.find('=');
+        if(equal == string::npos) {
+          cerr << PrintUsage() << endl;
+          exit(EXIT_FAILURE);
+        }
+        options.custom.push_back(make_pair(option.substr(0, equal),
+            option.substr(equal + 1)));
+        break;
+      }
+
+      case 'W': {
+        options.search_timeout_ms = atol(optarg);
+        break;
+      }
+
+      case 'n': {
+        arguments.num_engines = atoi(optarg);
+        break;
+      }
+
+      case 'O': {
+        arguments.output = string(optarg);
+        break;
+      }
+
+      case 'F': {
+        if(!AnalysisWriter::GetFormat(optarg, arguments.format)) {
+          cerr << PrintUsage() << endl;
+          exit(EXIT_FAILURE);
+        }
+        break;
+      }
+
+      case 'B': {
+        arguments.blunders_only = true;
+        break;
+      }
+
+      case 'C': {
+        arguments.checkpoint = string(optarg);
+        break;
+      }
+
+      case 'I': {
+        arguments.checkpoint_interval = atol(optarg);
+        break;
+      }
+
+      case 'R': {
+        arguments.resume = true;
+        break;
+      }
+
+      case 'c': {
+        arguments.cache = string(optarg);
+        break;
+      }
+
+      case 'z': {
+        arguments.cache_mb = atol(optarg);
         break;
       }
 
       default: {
-        PrintUsage();
+        cerr << PrintUsage() << endl;
         exit(EXIT_FAILURE);
       }
     }
   }
 
-  if(engine.compare("") == 0 || pgnfile.compare("") == 0) {
-    PrintUsage();
+  // PGN files can also follow the options
+  for(int i = optind; i < argc; ++i) {
+    arguments.pgnfiles.push_back(argv[i]);
+  }
+
+  // a checkpoint needs an output file it can be cut back to
+  bool has_checkpoint = !arguments.checkpoint.empty();
+  if(arguments.engine.empty() || arguments.pgnfiles.empty() ||
+     arguments.num_engines < 1 || arguments.checkpoint_interval == 0 ||
+     arguments.cache_mb == 0 ||
+     (has_checkpoint && arguments.output.empty()) ||
+     (arguments.resume && !has_checkpoint)) {
+    cerr << PrintUsage() << endl;
     exit(EXIT_FAILURE);
   }
 
-  if(!analize_light && !analize_dark) {
-    analize_light = true;
+  if(!arguments.analyze_light && !arguments.analyze_dark) {
+    arguments.analyze_light = true;
+  }
+
+  // one second per move, as before the other limits
+  if(limits.movetime_ms == 0 && limits.depth == 0 && limits.nodes == 0) {
+    limits.movetime_ms = 1000;
   }
 
-  return make_tuple(engine, pgnfile, analize_light, analize_dark, time_per_move, blunder_threshold);
+  return arguments;
 }
 
 string PrintUsage() {
-  return "chess-analyzer --engine=path-to-engine --pgnfile=path-to-pgn [--analize_light] "
-          "[--analize-dark] [--time_per_move=seconds] [--blunder_threshold=centipawns]";
+  return "chess-analyzer --engine=path-to-engine [--pgnfile=path-to-pgn]... [--analyze_light] "
+          "[--analyze_dark] [--engines=number] [--format=csv|ndjson] [--output=file] "
+          "[--blunders_only] [--checkpoint=file [--checkpoint_interval=games] [--resume]] "
+          "[--cache=file [--cache_size=megabytes]] "
+          "[--time_per_move=seconds] [--movetime=milliseconds] [--depth=plies] "
+          "[--nodes=number] [--stable=iterations] [--stable_margin=centipawns] "
+          "[--blunder_threshold=centipawns] "
+          "[--hash=megabytes] [--threads=number] [--multipv=lines] [--syzygy_path=path] "
+          "[--option=name=value]... [--search_timeout=milliseconds] [pgnfile]...";
 }
@@ -0,0 +1,149 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+
+// Cost of talking to engines, measured against the mock engine so the
+// searches themselves take no time: the time of a single search through
+// ChessEngineInterface, and the positions per second of an EnginePool.
+#include <getopt.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "ChessEngineInterface.h"
+#include "EnginePool.h"
+#include "MoveGenerator.h"
+
+using namespace std;
+using namespace acortes::chess;
+
+string PrintUsage() {
+  return "engine-bench --engine=path-to-mock-engine [--searches=number] "
+         "[--engines=number] [--depth=plies]";
+}
+
+// positions of random games, the same in every run
+vector<string> GetPositions(size_t num_positions) {
+  vector<string> positions;
+  mt19937 random(2014);
+  Board board(8,8);
+  board.LoadFEN(START_FEN);
+  MoveUndo undo;
+  int ply = 0;
+  while(positions.size() < num_positions) {
+    MoveList moves;
+    MoveGenerator::GenerateLegalMoves(board, moves);
+    // games of at most 80 plies
+    if(moves.Size() == 0 || ply == 80) {
+      board.LoadFEN(START_FEN);
+      ply = 0;
+      continue;
+    }
+    board.MakeMove(moves[random() % moves.Size()], undo);
+    ply++;
+    positions.push_back(board.FEN());
+  }
+  return positions;
+}
+
+long GetElapsedMicroseconds(chrono::steady_clock::time_point start) {
+  return chrono::duration_cast<chrono::microseconds>(
+      chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  string engine_path;
+  size_t num_searches = 2000;
+  int num_engines = 4;
+  SearchLimits limits;
+  limits.depth = 1;
+
+  static struct option long_options[] = {
+      {"engine", required_argument, 0, 'e'},
+      {"searches", required_argument, 0, 's'},
+      {"engines", required_argument, 0, 'n'},
+      {"depth", required_argument, 0, 'd'},
+      {0, 0, 0, 0}
+  };
+
+  int opt = 0;
+  int long_index = 0;
+
+  while((opt = getopt_long(argc, argv, "e:s:n:d:",
+          long_options, &long_index)) != -1) {
+    switch(opt) {
+      case 'e': {
+        engine_path = string(optarg);
+        break;
+      }
+
+      case 's': {
+        num_searches = atol(optarg);
+        break;
+      }
+
+      case 'n': {
+        num_engines = atoi(optarg);
+        break;
+      }
+
+      case 'd': {
+        limits.depth = atoi(optarg);
+        break;
+      }
+
+      default: {
+        cerr << PrintUsage() << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if(engine_path.empty() || num_searches == 0 || num_engines < 1 ||
+     limits.depth < 1) {
+    cerr << PrintUsage() << endl;
+    return EXIT_FAILURE;
+  }
+
+  vector<string> positions = GetPositions(num_searches);
+
+  // one engine, searches one after the other
+  {
+    auto start = chrono::steady_clock::now();
+    ChessEngineInterface engine(engine_path);
+    long startup = GetElapsedMicroseconds(start);
+    start = chrono::steady_clock::now();
+    for(const auto & fen : positions) {
+      engine.Analyze(fen, limits);
+    }
+    long elapsed = GetElapsedMicroseconds(start);
+    cout << "Engine start: " << startup / 1000 << " ms" << endl;
+    cout << "Searches: " << num_searches << " in " << elapsed / 1000 << " ms, "
+         << elapsed / num_searches << " us per search" << endl;
+  }
+
+  // the same searches spread over a pool
+  {
+    auto start = chrono::steady_clock::now();
+    EnginePool pool(engine_path, num_engines);
+    for(const auto & fen : positions) {
+      pool.AddPosition(fen, limits);
+    }
+    pool.Wait();
+    long elapsed = GetElapsedMicroseconds(start);
+    cout << "Pool of " << num_engines << ": " << num_searches << " in "
+         << elapsed / 1000 << " ms";
+    if(elapsed > 0) {
+      cout << ", " << num_searches * 1000000 / elapsed << " positions/s";
+    }
+    cout << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
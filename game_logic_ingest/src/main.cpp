@@ -0,0 +1,100 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <getopt.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "AnalysisWriter.h"
+#include "PGNDatabase.h"
+#include "PGNIngest.h"
+
+using namespace std;
+using namespace acortes::chess;
+
+string PrintUsage() {
+  return "pgn-ingest [--threads=number] [--quiet] pgnfile";
+}
+
+int main(int argc, char* argv[]) {
+  int num_threads = thread::hardware_concurrency();
+  bool quiet = false;
+
+  static struct option long_options[] = {
+      {"threads", required_argument, 0, 't'},
+      {"quiet", no_argument, 0, 'q'},
+      {0, 0, 0, 0}
+  };
+
+  int opt = 0;
+  int long_index = 0;
+
+  while((opt = getopt_long(argc, argv, "t:q",
+          long_options, &long_index)) != -1) {
+    switch(opt) {
+      case 't': {
+        num_threads = atoi(optarg);
+        break;
+      }
+
+      case 'q': {
+        quiet = true;
+        break;
+      }
+
+      default: {
+        cerr << PrintUsage() << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if(optind != argc - 1 || num_threads < 1) {
+    cerr << PrintUsage() << endl;
+    return EXIT_FAILURE;
+  }
+
+  PGNDatabase database(argv[optind]);
+  if(!database.IsOpen()) {
+    cerr << "Cannot open " << argv[optind] << endl;
+    return EXIT_FAILURE;
+  }
+
+  size_t num_errors = 0;
+  if(!quiet) {
+    cout << "game,event,white,black,result,moves,errors,key,fen" << endl;
+  }
+
+  PGNIngest ingest(num_threads);
+  auto start = chrono::steady_clock::now();
+  size_t num_games = ingest.Run(database, [&](const PGNGameSummary & game) {
+    num_errors += game.num_errors;
+    if(!quiet) {
+      cout << game.index + 1 << ","
+           << AnalysisWriter::CSVField(game.event) << ","
+           << AnalysisWriter::CSVField(game.white) << ","
+           << AnalysisWriter::CSVField(game.black) << ","
+           << game.result << ","
+           << game.num_moves << ","
+           << game.num_errors << ","
+           << hex << game.final_key << dec << ","
+           << game.final_fen << "\n";
+    }
+  });
+  auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+      chrono::steady_clock::now() - start).count();
+
+  cerr << "Games: " << num_games << endl;
+  cerr << "Errors: " << num_errors << endl;
+  cerr << "Time: " << elapsed << " ms" << endl;
+  if(elapsed > 0) {
+    cerr << "Games/s: " << num_games * 1000 / elapsed << endl;
+  }
+
+  return (num_errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
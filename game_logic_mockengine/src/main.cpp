@@ -0,0 +1,350 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+
+// Engine speaking the part of UCI used by ChessEngineInterface, for tests
+// and benchmarks without a real engine. Results only depend on the
+// position: the score and the best move come from its Zobrist key, or
+// from a script. The best move changes after depth 2 and is stable from
+// there, like the first iterations of a real search.
+//
+// It is started without arguments, so it is configured with environment
+// variables:
+//   MOCK_UCI_LATENCY_MS     time of each depth, 0 by default
+//   MOCK_UCI_MAX_DEPTH      last depth when no other limit ends the
+//                           search first, 20 by default
+//   MOCK_UCI_SCRIPT         file with lines "fen|score|pv", the score is
+//                           from the side to move. Move counters of the
+//                           FEN are not compared.
+//   MOCK_UCI_START_DELAY_MS time before the engine reads anything
+//   MOCK_UCI_CRASH_AFTER    the engine aborts in the middle of this search,
+//                           counted from 1
+//   MOCK_UCI_HANG_AFTER     the engine stops answering in this search
+//   MOCK_UCI_GARBAGE        if set, every search also writes lines that
+//                           are not valid UCI
+//   MOCK_UCI_LOWERBOUND     depths from this one fail high, their lines
+//                           have a higher score and "lowerbound"
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Board.h"
+#include "LineReader.h"
+#include "MoveGenerator.h"
+
+using namespace std;
+using namespace acortes::chess;
+
+namespace {
+
+const int NODES_PER_DEPTH = 1000;
+
+struct Result {
+  long score;
+  string line;
+};
+
+long GetEnv(const char * name, long default_value) {
+  const char * value = getenv(name);
+  return (value != nullptr) ? atol(value) : default_value;
+}
+
+// scripted results by the Zobrist key of the position
+map<uint64_t, Result> ReadScript(const char * filename) {
+  map<uint64_t, Result> script;
+  if(filename == nullptr) {
+    return script;
+  }
+  ifstream file(filename);
+  string line;
+  Board board(8,8);
+  while(getline(file, line)) {
+    size_t first = line.find('|');
+    size_t second = line.find('|', first + 1);
+    if(line.empty() || line[0] == '#' || second == string::npos ||
+       !board.LoadFEN(line.substr(0, first))) {
+      continue;
+    }
+    Result result = {atol(line.c_str() + first + 1), line.substr(second + 1)};
+    script[board.GetKey()] = result;
+  }
+  return script;
+}
+
+bool MakeUCIMove(Board & board, const string & uci) {
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  for(const auto & move : moves) {
+    if(move.UCI() == uci) {
+      MoveUndo undo;
+      board.MakeMove(move, undo);
+      return true;
+    }
+  }
+  return false;
+}
+
+// "startpos" or "fen <fen>", optionally followed by "moves <moves>"
+bool SetPosition(Board & board, const string & position) {
+  istringstream words(position);
+  string word;
+  words >> word;
+  string fen = START_FEN;
+  if(word == "fen") {
+    fen.clear();
+    while(words >> word && word != "moves") {
+      fen += (fen.empty() ? "" : " ") + word;
+    }
+  } else if(word != "startpos" || (words >> word && word != "moves")) {
+    return false;
+  }
+  if(!board.LoadFEN(fen)) {
+    return false;
+  }
+  while(words >> word) {
+    if(!MakeUCIMove(board, word)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// best line of a position with moves and the first move of a worse one
+Result Evaluate(const Board & board, const MoveList & moves,
+    const map<uint64_t, Result> & script, string & other_move) {
+  uint64_t key = board.GetKey();
+  other_move = moves[0].UCI();
+
+  auto scripted = script.find(key);
+  if(scripted != script.end()) {
+    return scripted->second;
+  }
+
+  PackedMove best = moves[(key >> 8) % moves.Size()];
+  Result result = {static_cast<long>(key % 201) - 100, best.UCI()};
+  Board next(board);
+  next.DetachPieces();
+  MoveUndo undo;
+  next.MakeMove(best, undo);
+  MoveList replies;
+  MoveGenerator::GenerateLegalMoves(next, replies);
+  if(replies.Size() > 0) {
+    result.line += " " + replies[(key >> 16) % replies.Size()].UCI();
+  }
+  return result;
+}
+
+void WriteGarbage() {
+  cout << endl;
+  cout << "info string \x01\x02\x7f not uci" << endl;
+  cout << "info depth x score cp abc pv" << endl;
+  cout << "info depth 3 score cp" << endl;
+  cout << "bestmov" << endl;
+  cout << string(LineReader::BUFFER_SIZE + 100, 'x') << endl;
+}
+
+class MockEngine {
+public:
+  MockEngine() :
+    board_(8,8), latency_ms_(GetEnv("MOCK_UCI_LATENCY_MS", 0)),
+    max_depth_(GetEnv("MOCK_UCI_MAX_DEPTH", 20)),
+    crash_after_(GetEnv("MOCK_UCI_CRASH_AFTER", 0)),
+    hang_after_(GetEnv("MOCK_UCI_HANG_AFTER", 0)),
+    garbage_(getenv("MOCK_UCI_GARBAGE") != nullptr),
+    lowerbound_(GetEnv("MOCK_UCI_LOWERBOUND", 0)),
+    script_(ReadScript(getenv("MOCK_UCI_SCRIPT"))), num_searches_(0),
+    reader_(STDIN_FILENO) {
+    board_.LoadFEN(START_FEN);
+  }
+
+  void Run() {
+    TextSpan line;
+    while(reader_.WaitForLine()) {
+      while(reader_.GetLine(line)) {
+        pending_.push_back(line.ToString());
+      }
+      // commands that arrive during a search are run after it
+      while(!pending_.empty()) {
+        string command = pending_.front();
+        pending_.pop_front();
+        if(!Command(command)) {
+          return;
+        }
+      }
+    }
+  }
+
+private:
+  Board board_;
+  long latency_ms_;
+  long max_depth_;
+  long crash_after_;
+  long hang_after_;
+  bool garbage_;
+  long lowerbound_;
+  map<uint64_t, Result> script_;
+  long num_searches_;
+  LineReader reader_;
+  deque<string> pending_;
+
+  // false on quit
+  bool Command(const string & command) {
+    if(command == "uci") {
+      cout << "id name Mock 1.0" << endl;
+      cout << "id author A. Cortes" << endl;
+      cout << "option name Hash type spin default 16 min 1 max 4096" << endl;
+      cout << "option name Threads type spin default 1 min 1 max 64" << endl;
+      cout << "option name MultiPV type spin default 1 min 1 max 10" << endl;
+      cout << "uciok" << endl;
+    } else if(command == "isready") {
+      cout << "readyok" << endl;
+    } else if(command.compare(0, 9, "position ") == 0) {
+      if(!SetPosition(board_, command.substr(9))) {
+        cout << "info string invalid position" << endl;
+        board_.LoadFEN(START_FEN);
+      }
+    } else if(command.compare(0, 2, "go") == 0) {
+      Go(command);
+    } else if(command == "quit") {
+      return false;
+    }
+    // ucinewgame, setoption and stop outside of a search need no answer
+    return true;
+  }
+
+  void Go(const string & command) {
+    num_searches_++;
+    long depth = 0;
+    long nodes = 0;
+    long movetime_ms = 0;
+    bool is_infinite = false;
+    istringstream words(command);
+    string word;
+    while(words >> word) {
+      if(word == "depth") {
+        words >> depth;
+      } else if(word == "nodes") {
+        words >> nodes;
+      } else if(word == "movetime") {
+        words >> movetime_ms;
+      } else if(word == "infinite") {
+        is_infinite = true;
+      }
+    }
+    // a go without limits is an infinite search
+    if(depth == 0 && nodes == 0 && movetime_ms == 0) {
+      is_infinite = true;
+    }
+
+    // like real engines, a position without moves has a single line
+    // without a variation, and an infinite search still waits for stop
+    MoveList moves;
+    MoveGenerator::GenerateLegalMoves(board_, moves);
+    if(moves.Size() == 0) {
+      cout << "info depth 0 score "
+           << (MoveGenerator::IsInCheck(board_) ? "mate 0" : "cp 0") << endl;
+      while(is_infinite && Wait(-1)) {
+      }
+      cout << "bestmove (none)" << endl;
+      return;
+    }
+
+    string other_move;
+    Result result = Evaluate(board_, moves, script_, other_move);
+    auto start = chrono::steady_clock::now();
+    bool is_stopped = false;
+    string pv;
+
+    for(long d = 1; !is_stopped; ++d) {
+      if(!Wait(latency_ms_)) {
+        is_stopped = true;
+      }
+      pv = (d > 2) ? result.line : other_move;
+      long elapsed = chrono::duration_cast<chrono::milliseconds>(
+          chrono::steady_clock::now() - start).count();
+      long score = (pv == result.line) ? result.score : result.score - 30;
+      bool is_bound = lowerbound_ > 0 && d >= lowerbound_;
+      cout << "info depth " << d << " seldepth " << d + 2 << " multipv 1"
+           << " score cp " << (is_bound ? score + 50 : score)
+           << (is_bound ? " lowerbound" : "") << " nodes " << d * NODES_PER_DEPTH << " time " << elapsed
+           << " pv " << pv << endl;
+
+      if(garbage_ && d == 1) {
+        WriteGarbage();
+      }
+      if(num_searches_ == crash_after_) {
+        abort();
+      }
+      if(num_searches_ == hang_after_) {
+        while(true) {
+          this_thread::sleep_for(chrono::seconds(1));
+        }
+      }
+
+      // the first limit reached ends the search, an infinite search
+      // waits for stop even after the last depth
+      if((depth > 0 && d >= depth) || (nodes > 0 && d * NODES_PER_DEPTH >= nodes) ||
+         (movetime_ms > 0 && elapsed >= movetime_ms) || d >= max_depth_) {
+        if(is_infinite) {
+          while(!is_stopped && Wait(-1)) {
+          }
+        }
+        break;
+      }
+    }
+
+    // the first move of the last line
+    cout << "bestmove " << pv.substr(0, pv.find(' ')) << endl;
+  }
+
+  // false if stop arrives, or the input is closed, in the time given
+  bool Wait(long time_ms) {
+    // stop may have been read with the go command
+    for(auto command = pending_.begin(); command != pending_.end(); ++command) {
+      if(*command == "stop") {
+        pending_.erase(command);
+        return false;
+      }
+    }
+    auto end = chrono::steady_clock::now() + chrono::milliseconds(time_ms);
+    reader_.Read();
+    while(true) {
+      TextSpan line;
+      while(reader_.GetLine(line)) {
+        if(line == "stop") {
+          return false;
+        } else if(line == "isready") {
+          cout << "readyok" << endl;
+        } else {
+          pending_.push_back(line.ToString());
+        }
+      }
+      long remaining = (time_ms < 0) ? -1 : chrono::duration_cast<chrono::milliseconds>(
+          end - chrono::steady_clock::now()).count();
+      if(time_ms >= 0 && remaining <= 0) {
+        return true;
+      }
+      if(!reader_.WaitForLine(remaining) && reader_.IsClosed()) {
+        return false;
+      }
+    }
+  }
+};
+
+}
+
+int main() {
+  this_thread::sleep_for(chrono::milliseconds(GetEnv("MOCK_UCI_START_DELAY_MS", 0)));
+  MockEngine engine;
+  engine.Run();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include <getopt.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "Board.h"
+#include "Perft.h"
+
+using namespace std;
+using namespace acortes::chess;
+
+string PrintUsage() {
+  return "perft [--fen=position] [--depth=plies] [--threads=number] "
+         "[--hash=megabytes] [--divide]";
+}
+
+int main(int argc, char* argv[]) {
+  string fen = START_FEN;
+  int depth = 5;
+  int num_threads = 1;
+  size_t hash_size_mb = 0;
+  bool divide = false;
+
+  static struct option long_options[] = {
+      {"fen", required_argument, 0, 'f'},
+      {"depth", required_argument, 0, 'd'},
+      {"threads", required_argument, 0, 't'},
+      {"hash", required_argument, 0, 'H'},
+      {"divide", no_argument, 0, 'D'},
+      {0, 0, 0, 0}
+  };
+
+  int opt = 0;
+  int long_index = 0;
+
+  while((opt = getopt_long(argc, argv, "f:d:t:H:D",
+          long_options, &long_index)) != -1) {
+    switch(opt) {
+      case 'f': {
+        fen = string(optarg);
+        break;
+      }
+
+      case 'd': {
+        depth = atoi(optarg);
+        break;
+      }
+
+      case 't': {
+        num_threads = atoi(optarg);
+        break;
+      }
+
+      case 'H': {
+        hash_size_mb = atol(optarg);
+        break;
+      }
+
+      case 'D': {
+        divide = true;
+        break;
+      }
+
+      default: {
+        cerr << PrintUsage() << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  Board board(8,8);
+  if(depth < 1 || num_threads < 1 || !board.LoadFEN(fen)) {
+    cerr << PrintUsage() << endl;
+    return EXIT_FAILURE;
+  }
+
+  Perft perft(hash_size_mb);
+  auto start = chrono::steady_clock::now();
+  auto roots = perft.Divide(board, depth, num_threads);
+  auto elapsed = chrono::duration_cast<chrono::microseconds>(
+      chrono::steady_clock::now() - start).count();
+
+  uint64_t nodes = 0;
+  for(const auto & root : roots) {
+    if(divide) {
+      cout << root.first.UCI() << ": " << root.second << endl;
+    }
+    nodes += root.second;
+  }
+
+  if(divide) {
+    cout << endl << "Moves: " << roots.size() << endl;
+  }
+  cout << "Nodes: " << nodes << endl;
+  cout << "Time: " << elapsed / 1000 << " ms" << endl;
+  if(elapsed > 0) {
+    cout << "NPS: " << nodes * 1000000 / elapsed << endl;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+
+// Scaling of the native search with threads: the same positions are
+// searched to a fixed depth with 1, 2, 4... threads, each time with an
+// empty table, and the nodes per second and the time to reach the depth
+// are compared with the ones of a single thread.
+#include <getopt.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ChessEngineInterface.h"
+#include "NativeEngine.h"
+
+using namespace std;
+using namespace acortes::chess;
+
+string PrintUsage() {
+  return "search-bench [--depth=plies] [--threads=max threads] [--hash=MB]";
+}
+
+// an opening, a middlegame and an endgame
+const vector<string> POSITIONS = {
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+};
+
+struct BenchResult {
+  long time_ms;
+  uint64_t nodes;
+};
+
+BenchResult Run(int num_threads, int depth, size_t hash_mb) {
+  BenchResult result = {0, 0};
+  SearchLimits limits;
+  limits.depth = depth;
+  for(const auto & fen : POSITIONS) {
+    NativeEngine engine(hash_mb, num_threads);
+    Evaluation evaluation = engine.Analyze(fen, limits);
+    result.time_ms += evaluation.time_ms;
+    result.nodes += evaluation.nodes;
+  }
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  int depth = 8;
+  // 0 when the number of cores is not known
+  int max_threads = max(thread::hardware_concurrency(), 1u);
+  size_t hash_mb = 64;
+
+  static struct option long_options[] = {
+      {"depth", required_argument, 0, 'd'},
+      {"threads", required_argument, 0, 't'},
+      {"hash", required_argument, 0, 'H'},
+      {0, 0, 0, 0}
+  };
+
+  int opt = 0;
+  int long_index = 0;
+
+  while((opt = getopt_long(argc, argv, "d:t:H:",
+          long_options, &long_index)) != -1) {
+    switch(opt) {
+      case 'd': {
+        depth = atoi(optarg);
+        break;
+      }
+
+      case 't': {
+        max_threads = atoi(optarg);
+        break;
+      }
+
+      case 'H': {
+        hash_mb = atol(optarg);
+        break;
+      }
+
+      default: {
+        cerr << PrintUsage() << endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if(depth < 1 || depth >= NativeEngine::MAX_PLY || max_threads < 1 ||
+     hash_mb == 0) {
+    cerr << PrintUsage() << endl;
+    return EXIT_FAILURE;
+  }
+
+  // powers of two, and the maximum if it is not one
+  vector<int> thread_counts;
+  for(int threads = 1; threads < max_threads; threads *= 2) {
+    thread_counts.push_back(threads);
+  }
+  thread_counts.push_back(max_threads);
+
+  cout << "Depth " << depth << ", " << POSITIONS.size() << " positions, "
+       << hash_mb << " MB table" << endl;
+  printf("%8s %10s %12s %10s %8s %8s\n",
+         "threads", "time ms", "nodes", "knps", "speedup", "nps x");
+  BenchResult single = {0, 0};
+  for(int threads : thread_counts) {
+    BenchResult result = Run(threads, depth, hash_mb);
+    if(threads == 1) {
+      single = result;
+    }
+    long time_ms = max(result.time_ms, 1L);
+    uint64_t nps = result.nodes * 1000 / time_ms;
+    uint64_t single_nps = single.nodes * 1000 / max(single.time_ms, 1L);
+    printf("%8d %10ld %12llu %10llu %8.2f %8.2f\n", threads, result.time_ms,
+           static_cast<unsigned long long>(result.nodes),
+           static_cast<unsigned long long>(nps / 1000),
+           static_cast<double>(max(single.time_ms, 1L)) / time_ms,
+           single_nps > 0 ? static_cast<double>(nps) / single_nps : 0.0);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "AnalysisCache.h"
+#include "ChessEngineInterface.h"
+#include "UCIInfo.h"
+#include <unistd.h>
+#include <cstdio>
+
+using namespace std;
+using namespace acortes::chess;
+
+class AnalysisCacheTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    char filename[] = "/tmp/AnalysisCacheTestXXXXXX";
+    int fd = mkstemp(filename);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    filename_ = filename;
+    engine_ = AnalysisCache::GetEngineId("Stockfish 5");
+    limits_.movetime_ms = 1000;
+
+    evaluation_.score = -35;
+    evaluation_.depth = 18;
+    evaluation_.best = "e7e5";
+    evaluation_.line = "e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 e1g1 f8e7";
+  }
+
+  virtual void TearDown() {
+    remove(filename_.c_str());
+  }
+
+  string filename_;
+  uint32_t engine_;
+  SearchLimits limits_;
+  Evaluation evaluation_;
+};
+
+TEST_F(AnalysisCacheTest, FindStored) {
+  AnalysisCache cache(filename_, 1);
+  ASSERT_TRUE(cache.IsOpen());
+  Evaluation evaluation;
+  ASSERT_FALSE(cache.Find(1234, engine_, limits_, evaluation));
+  cache.Store(1234, engine_, limits_, evaluation_);
+  ASSERT_TRUE(cache.Find(1234, engine_, limits_, evaluation));
+  ASSERT_EQ(-35, evaluation.score);
+  ASSERT_EQ(18, evaluation.depth);
+  ASSERT_EQ("e7e5", evaluation.best);
+  ASSERT_EQ("e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 e1g1 f8e7", evaluation.line);
+}
+
+TEST_F(AnalysisCacheTest, WholeLines) {
+  AnalysisCache cache(filename_, 1);
+  Evaluation evaluation;
+  // the longest line the engine interface keeps, with a promotion
+  string line = "a2a4";
+  for(size_t i = 1; i < UCIInfo::MAX_PV_LENGTH - 1; ++i) {
+    line += (i % 2 == 1) ? " h7h5" : " a4a5";
+  }
+  evaluation_.line = line + " b7b8q";
+  cache.Store(1, engine_, limits_, evaluation_);
+  ASSERT_TRUE(cache.Find(1, engine_, limits_, evaluation));
+  ASSERT_EQ(evaluation_.line, evaluation.line);
+
+  // a line that cannot be kept whole is not stored
+  for(size_t i = 0; i < 20; ++i) {
+    evaluation_.line += " a4a5";
+  }
+  cache.Store(2, engine_, limits_, evaluation_);
+  evaluation_.line = "e7e5 (none)";
+  cache.Store(3, engine_, limits_, evaluation_);
+  ASSERT_FALSE(cache.Find(2, engine_, limits_, evaluation));
+  ASSERT_FALSE(cache.Find(3, engine_, limits_, evaluation));
+
+  // a position without moves has no best move nor line
+  evaluation_.best.clear();
+  evaluation_.line.clear();
+  cache.Store(4, engine_, limits_, evaluation_);
+  ASSERT_TRUE(cache.Find(4, engine_, limits_, evaluation));
+  ASSERT_EQ("", evaluation.best);
+  ASSERT_EQ("", evaluation.line);
+}
+
+TEST_F(AnalysisCacheTest, OnlyLongerSearchesOfTheSameEngine) {
+  AnalysisCache cache(filename_, 1);
+  cache.Store(1234, engine_, limits_, evaluation_);
+  Evaluation evaluation;
+  SearchLimits limits;
+  limits.movetime_ms = 500;
+  ASSERT_TRUE(cache.Find(1234, engine_, limits, evaluation));
+  limits.movetime_ms = 2000;
+  ASSERT_FALSE(cache.Find(1234, engine_, limits, evaluation));
+  ASSERT_FALSE(cache.Find(1234, AnalysisCache::GetEngineId("Stockfish 6"),
+      limits_, evaluation));
+  ASSERT_FALSE(cache.Find(4321, engine_, limits_, evaluation));
+}
+
+TEST_F(AnalysisCacheTest, OnlyCoveredLimits) {
+  AnalysisCache cache(filename_, 1);
+  SearchLimits depth;
+  depth.depth = 20;
+  cache.Store(1, engine_, depth, evaluation_);
+  SearchLimits adaptive = limits_;
+  adaptive.stable_iterations = 4;
+  cache.Store(2, engine_, adaptive, evaluation_);
+
+  Evaluation evaluation;
+  // a time limited search may not reach the depth, and the other way
+  ASSERT_FALSE(cache.Find(1, engine_, limits_, evaluation));
+  depth.depth = 18;
+  ASSERT_TRUE(cache.Find(1, engine_, depth, evaluation));
+  depth.movetime_ms = 1000;
+  ASSERT_TRUE(cache.Find(1, engine_, depth, evaluation));
+
+  // an adaptive search may stop earlier than a search of fixed time
+  ASSERT_FALSE(cache.Find(2, engine_, limits_, evaluation));
+  ASSERT_TRUE(cache.Find(2, engine_, adaptive, evaluation));
+  adaptive.stable_iterations = 6;
+  ASSERT_FALSE(cache.Find(2, engine_, adaptive, evaluation));
+}
+
+TEST_F(AnalysisCacheTest, KeptInTheFile) {
+  {
+    AnalysisCache cache(filename_, 1);
+    cache.Store(1234, engine_, limits_, evaluation_);
+  }
+  // the size given when the file is open again is ignored
+  AnalysisCache cache(filename_, 4);
+  ASSERT_TRUE(cache.IsOpen());
+  ASSERT_EQ(1024u * 1024u / 128u, cache.GetNumEntries());
+  Evaluation evaluation;
+  ASSERT_TRUE(cache.Find(1234, engine_, limits_, evaluation));
+  ASSERT_EQ(-35, evaluation.score);
+}
+
+TEST_F(AnalysisCacheTest, LowestDepthReplaced) {
+  AnalysisCache cache(filename_, 1);
+  // keys of the same bucket
+  uint64_t step = cache.GetNumEntries();
+  for(uint64_t i = 1; i <= 4; ++i) {
+    evaluation_.depth = 10 + i;
+    cache.Store(i * step, engine_, limits_, evaluation_);
+  }
+  cache.Store(5 * step, engine_, limits_, evaluation_);
+  Evaluation evaluation;
+  ASSERT_FALSE(cache.Find(1 * step, engine_, limits_, evaluation));
+  for(uint64_t i = 2; i <= 5; ++i) {
+    ASSERT_TRUE(cache.Find(i * step, engine_, limits_, evaluation));
+  }
+}
+
+TEST_F(AnalysisCacheTest, OneProcessAtATime) {
+  AnalysisCache cache(filename_, 1);
+  ASSERT_TRUE(cache.IsOpen());
+  // the lock belongs to the open file, a second one is refused
+  AnalysisCache other(filename_, 1);
+  ASSERT_FALSE(other.IsOpen());
+}
+
+TEST_F(AnalysisCacheTest, OtherFilesNotUsed) {
+  FILE * file = fopen(filename_.c_str(), "w");
+  fputs("[Event \"not a cache\"]\n", file);
+  fclose(file);
+  AnalysisCache cache(filename_, 1);
+  ASSERT_FALSE(cache.IsOpen());
+  Evaluation evaluation;
+  ASSERT_FALSE(cache.Find(1234, engine_, limits_, evaluation));
+}
@@ -0,0 +1,54 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "AnalysisCheckpoint.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+using namespace acortes::chess;
+
+class AnalysisCheckpointTest : public ::testing::Test {
+protected:
+  virtual void TearDown() {
+    remove(filename_.c_str());
+  }
+
+  string filename_ = "test_checkpoint.txt";
+};
+
+TEST_F(AnalysisCheckpointTest, SavedAndLoaded) {
+  AnalysisCheckpoint checkpoint(filename_);
+  ASSERT_FALSE(checkpoint.Load());
+  checkpoint.SetNumGamesDone("games.pgn", 120);
+  checkpoint.SetNumGamesDone("more games.pgn", 7);
+  checkpoint.SetNumGamesDone("games.pgn", 150);
+  checkpoint.SetOutputSize(1ULL << 33);
+  ASSERT_TRUE(checkpoint.Save());
+
+  AnalysisCheckpoint loaded(filename_);
+  ASSERT_TRUE(loaded.Load());
+  ASSERT_EQ(150U, loaded.GetNumGamesDone("games.pgn"));
+  ASSERT_EQ(7U, loaded.GetNumGamesDone("more games.pgn"));
+  ASSERT_EQ(0U, loaded.GetNumGamesDone("other.pgn"));
+  ASSERT_EQ(1ULL << 33, loaded.GetOutputSize());
+}
+
+TEST_F(AnalysisCheckpointTest, DamagedFileNotUsed) {
+  AnalysisCheckpoint checkpoint(filename_);
+  checkpoint.SetNumGamesDone("games.pgn", 10);
+  checkpoint.SetOutputSize(500);
+  ASSERT_TRUE(checkpoint.Save());
+
+  ofstream file(filename_, ios::app);
+  file << "12";
+  file.close();
+  AnalysisCheckpoint damaged(filename_);
+  ASSERT_FALSE(damaged.Load());
+  ASSERT_EQ(0U, damaged.GetNumGamesDone("games.pgn"));
+  ASSERT_EQ(0U, damaged.GetOutputSize());
+}
@@ -0,0 +1,78 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "AnalysisWriter.h"
+#include <sstream>
+
+using namespace std;
+using namespace acortes::chess;
+
+class AnalysisWriterTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    game_ = {"games.pgn", 0, "Carlsen, Magnus", "Anand \"Vishy\""};
+
+    // 1. e4 e5, the second move loses a pawn
+    MoveAnalysis e4;
+    e4.ply = 0;
+    e4.move = "e4";
+    e4.best.score = 35;
+    e4.best.depth = 20;
+    e4.best.best = "e2e4";
+    e4.best.line = "e2e4 e7e5";
+    e4.played.score = 30;
+    e4.is_blunder = false;
+    MoveAnalysis f6 = e4;
+    f6.ply = 1;
+    f6.move = "f6";
+    f6.best.score = 30;
+    f6.best.best = "e7e5";
+    f6.best.line = "e7e5 g1f3";
+    f6.played.score = 140;
+    f6.is_blunder = true;
+    analysis_.moves.push_back(e4);
+    analysis_.moves.push_back(f6);
+  }
+
+  AnalyzedGame game_;
+  GameAnalysis analysis_;
+};
+
+TEST_F(AnalysisWriterTest, CSV) {
+  ostringstream output;
+  {
+    AnalysisWriter writer(output, AnalysisWriter::Format::CSV);
+    ASSERT_EQ(2U, writer.Write(game_, analysis_));
+    // nothing is written until the buffer is flushed
+    ASSERT_TRUE(output.str().empty());
+  }
+  ASSERT_EQ("file,game,white,black,ply,side,move,best_move,pre_score,pre_mate,"
+            "post_score,post_mate,loss,depth,blunder,pv\n"
+            "games.pgn,1,\"Carlsen, Magnus\",\"Anand \"\"Vishy\"\"\",1,w,e4,e2e4,"
+            "35,0,30,0,5,20,0,e2e4 e7e5\n"
+            "games.pgn,1,\"Carlsen, Magnus\",\"Anand \"\"Vishy\"\"\",2,b,f6,e7e5,"
+            "30,0,140,0,110,20,1,e7e5 g1f3\n", output.str());
+}
+
+TEST_F(AnalysisWriterTest, BlundersAsNDJSON) {
+  AnalysisWriter::Format format;
+  ASSERT_TRUE(AnalysisWriter::GetFormat("ndjson", format));
+  ASSERT_FALSE(AnalysisWriter::GetFormat("xml", format));
+
+  ostringstream output;
+  AnalysisWriter writer(output, format, true);
+  ASSERT_EQ(1U, writer.Write(game_, analysis_));
+  // moves without a valid analysis are left out
+  analysis_.moves[1].played.is_valid = false;
+  ASSERT_EQ(0U, writer.Write(game_, analysis_));
+  writer.Flush();
+  ASSERT_EQ("{\"file\":\"games.pgn\",\"game\":1,\"white\":\"Carlsen, Magnus\","
+            "\"black\":\"Anand \\\"Vishy\\\"\",\"ply\":2,\"side\":\"b\","
+            "\"move\":\"f6\",\"best_move\":\"e7e5\",\"pre_score\":30,\"pre_mate\":0,"
+            "\"post_score\":140,\"post_mate\":0,\"loss\":110,\"depth\":20,"
+            "\"blunder\":true,\"pv\":\"e7e5 g1f3\"}\n", output.str());
+}
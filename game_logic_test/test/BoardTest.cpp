@@ -0,0 +1,71 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Piece.h"
+#include "PGNPlayer.h"
+#include "PGNReader.h"
+using namespace acortes::chess;
+using namespace std;
+
+class BoardTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    // no moves are read, players are only used to own the pieces
+    pgn_ = new PGNReader("");
+    light_ = new PGNPlayer(Color::Light, pgn_);
+    dark_ = new PGNPlayer(Color::Dark, pgn_);
+    board_ = new Board(8,8);
+    light_->InitialSetup(board_);
+    dark_->InitialSetup(board_);
+  }
+
+  virtual void TearDown() {
+    delete light_;
+    delete dark_;
+    delete pgn_;
+    delete board_;
+  }
+
+  PGNReader * pgn_;
+  Player * light_;
+  Player * dark_;
+  Board * board_;
+};
+
+TEST_F(BoardTest, InitialBitboards) {
+  ASSERT_EQ(0xFFFF00000000FFFFULL, board_->GetOccupancy());
+  ASSERT_EQ(0x000000000000FFFFULL, board_->GetPieces(Color::Light));
+  ASSERT_EQ(0xFFFF000000000000ULL, board_->GetPieces(Color::Dark));
+  ASSERT_EQ(0x000000000000FF00ULL, board_->GetPieces(PieceType::Pawn, Color::Light));
+  ASSERT_EQ(0x1000000000000000ULL, board_->GetPieces(PieceType::King, Color::Dark));
+  ASSERT_EQ(PieceType::Queen, board_->GetPieceType(GetSquare(3, 0)));
+  ASSERT_EQ(PieceType::None, board_->GetPieceType(GetSquare(3, 3)));
+}
+
+TEST_F(BoardTest, InitialFEN) {
+  ASSERT_EQ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR", board_->FEN());
+}
+
+TEST_F(BoardTest, RemoveAndPut) {
+  Piece * knight = board_->RemovePiece(6, 0);
+  ASSERT_TRUE(board_->IsEmpty(6, 0));
+  ASSERT_EQ(0ULL, board_->GetPieces(PieceType::Knight, Color::Light) & SquareBB(GetSquare(6, 0)));
+
+  board_->PutPiece(knight, 5, 2);
+  ASSERT_EQ(knight, board_->GetPiece(5, 2));
+  ASSERT_EQ(PieceType::Knight, board_->GetPieceType(GetSquare(5, 2)));
+  ASSERT_EQ("rnbqkbnr/pppppppp/8/8/8/5N2/PPPPPPPP/RNBQKB1R", board_->FEN());
+}
+
+TEST_F(BoardTest, PathClear) {
+  // a1 rook is blocked by the a2 pawn, c1 bishop by the b2 pawn
+  ASSERT_FALSE(board_->IsPathClear(0, 0, 0, 5));
+  ASSERT_FALSE(board_->IsPathClear(2, 0, 0, 2));
+  ASSERT_TRUE(board_->IsPathClear(0, 1, 0, 5));
+  ASSERT_TRUE(board_->IsPathClear(0, 0, 0, 1));
+}
@@ -0,0 +1,331 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "AnalysisCache.h"
+#include "Board.h"
+#include "ChessEngineInterface.h"
+#include "EnginePool.h"
+#include "PGNDatabase.h"
+#include "PGNPlayer.h"
+#include "PGNReader.h"
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+using namespace std;
+using namespace acortes::chess;
+
+// the mock engine of game_logic_mockengine, its path can be changed with
+// MOCK_UCI_ENGINE
+class ChessEngineInterfaceTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    const char * path = getenv("MOCK_UCI_ENGINE");
+    engine_path_ = (path != nullptr) ? path : "../game_logic_mockengine/Debug/mock-engine";
+    ASSERT_EQ(0, access(engine_path_.c_str(), X_OK))
+        << "build game_logic_mockengine or set MOCK_UCI_ENGINE";
+
+    ofstream script(script_);
+    script << "# the initial position and the one after 1. e4" << endl;
+    script << START_FEN << "|35|e2e4 e7e5" << endl;
+    script << "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1|-20|c7c5 g1f3" << endl;
+    script.close();
+    setenv("MOCK_UCI_SCRIPT", script_.c_str(), 1);
+
+    ofstream pgn_file(pgn_);
+    pgn_file << "[Event \"test\"]" << endl << endl;
+    pgn_file << "1. e4 c5 2. Nf3 d6 3. d4 cxd4 4. Nxd4 Nf6 5. Nc3 a6 *" << endl;
+    pgn_file.close();
+
+    depth_.depth = 5;
+  }
+
+  virtual void TearDown() {
+    const char * variables[] = {"MOCK_UCI_SCRIPT", "MOCK_UCI_LATENCY_MS",
+        "MOCK_UCI_GARBAGE", "MOCK_UCI_START_DELAY_MS", "MOCK_UCI_CRASH_AFTER",
+        "MOCK_UCI_HANG_AFTER", "MOCK_UCI_LOWERBOUND"};
+    for(const char * variable : variables) {
+      unsetenv(variable);
+    }
+    remove(script_.c_str());
+    remove(pgn_.c_str());
+  }
+
+  GameAnalysis AnalyzeGame(ChessEngineInterface & engine) {
+    PGNReader pgn(pgn_);
+    Board board(8,8);
+    PGNPlayer player1(Color::Light, &pgn);
+    PGNPlayer player2(Color::Dark, &pgn);
+    Game game(&board, &player1, &player2);
+    game.InitialSetup();
+    return engine.Analyze(game, true, true, depth_, 50);
+  }
+
+  string engine_path_;
+  string script_ = "test_mock_engine.txt";
+  string pgn_ = "test_engine.pgn";
+  SearchLimits depth_;
+};
+
+TEST_F(ChessEngineInterfaceTest, Handshake) {
+  ChessEngineInterface engine(engine_path_);
+  ASSERT_EQ("Mock 1.0", engine.GetEngineName());
+  ASSERT_TRUE(engine.HasOption("Hash"));
+  ASSERT_TRUE(engine.HasOption("MultiPV"));
+  ASSERT_FALSE(engine.HasOption("SyzygyPath"));
+}
+
+TEST_F(ChessEngineInterfaceTest, ScriptedPositions) {
+  ChessEngineInterface engine(engine_path_);
+  Evaluation evaluation = engine.Analyze(START_FEN, depth_);
+  ASSERT_EQ(35, evaluation.score);
+  ASSERT_EQ(5, evaluation.depth);
+  ASSERT_EQ("e2e4", evaluation.best);
+  ASSERT_EQ("e2e4 e7e5", evaluation.line);
+
+  // scores are given from the light side
+  evaluation = engine.Analyze(
+      "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", depth_);
+  ASSERT_EQ(20, evaluation.score);
+  ASSERT_EQ("c7c5", evaluation.best);
+}
+
+TEST_F(ChessEngineInterfaceTest, Limits) {
+  ChessEngineInterface engine(engine_path_);
+  SearchLimits limits;
+  limits.nodes = 3000;
+  ASSERT_EQ(3, engine.Analyze(START_FEN, limits).depth);
+  limits.depth = 2;
+  ASSERT_EQ(2, engine.Analyze(START_FEN, limits).depth);
+
+  // without limits the engine is not asked, like a real one the mock
+  // engine would only end "go infinite" when it gets a stop
+  ASSERT_FALSE(engine.Analyze(START_FEN, SearchLimits()).is_valid);
+  ASSERT_EQ(0, engine.GetNumRestarts());
+
+  // the mock engine is stable from depth 3
+  setenv("MOCK_UCI_LATENCY_MS", "10", 1);
+  ChessEngineInterface slow_engine(engine_path_);
+  SearchLimits adaptive;
+  adaptive.stable_iterations = 3;
+  Evaluation evaluation = slow_engine.Analyze(START_FEN, adaptive);
+  ASSERT_LE(6, evaluation.depth);
+  ASSERT_GE(8, evaluation.depth);
+  ASSERT_EQ("e2e4", evaluation.best);
+
+  // a position without moves has no variation to become stable, like a
+  // real engine the mock one waits for a stop
+  evaluation = slow_engine.Analyze("7k/6Q1/6K1/8/8/8/8/8 b - - 0 1", adaptive);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ(MATE_SCORE, evaluation.score);
+  ASSERT_EQ(0, slow_engine.GetNumRestarts());
+}
+
+TEST_F(ChessEngineInterfaceTest, IncrementalGame) {
+  ChessEngineInterface engine(engine_path_);
+  GameAnalysis by_fen = AnalyzeGame(engine);
+  engine.SetIncremental(true);
+  GameAnalysis incremental = AnalyzeGame(engine);
+
+  ASSERT_EQ(10U, by_fen.moves.size());
+  ASSERT_EQ(by_fen.moves.size(), incremental.moves.size());
+  for(size_t i = 0; i < by_fen.moves.size(); ++i) {
+    ASSERT_EQ(by_fen.moves[i].best.score, incremental.moves[i].best.score);
+    ASSERT_EQ(by_fen.moves[i].played.score, incremental.moves[i].played.score);
+    ASSERT_EQ(by_fen.moves[i].best.line, incremental.moves[i].best.line);
+  }
+  ASSERT_EQ(35, by_fen.moves[0].best.score);
+  ASSERT_EQ(20, by_fen.moves[0].played.score);
+  ASSERT_EQ("e4", by_fen.moves[0].move);
+}
+
+TEST_F(ChessEngineInterfaceTest, CachedResults) {
+  char filename[] = "/tmp/ChessEngineInterfaceTestXXXXXX";
+  int fd = mkstemp(filename);
+  ASSERT_NE(-1, fd);
+  close(fd);
+  {
+    AnalysisCache cache(filename, 1);
+    ChessEngineInterface engine(engine_path_);
+    engine.SetCache(&cache);
+    ASSERT_EQ(35, engine.Analyze(START_FEN, depth_).score);
+  }
+
+  // the engine would answer differently now, the stored result is used
+  remove(script_.c_str());
+  {
+    AnalysisCache cache(filename, 1);
+    ChessEngineInterface engine(engine_path_);
+    engine.SetCache(&cache);
+    ASSERT_EQ(35, engine.Analyze(START_FEN, depth_).score);
+    depth_.depth = 10;
+    ASSERT_NE(35, engine.Analyze(START_FEN, depth_).score);
+  }
+
+  // a search cut short by the watchdog is not stored
+  setenv("MOCK_UCI_LATENCY_MS", "20", 1);
+  {
+    EngineOptions options;
+    options.search_timeout_ms = 50;
+    AnalysisCache cache(filename, 1);
+    ChessEngineInterface engine(engine_path_, false, options);
+    engine.SetCache(&cache);
+    depth_.depth = 15;
+    ASSERT_GT(15, engine.Analyze(START_FEN, depth_).depth);
+    Board board(8,8);
+    ASSERT_TRUE(board.LoadFEN(START_FEN));
+    Evaluation evaluation;
+    ASSERT_FALSE(cache.Find(board.GetKey(), AnalysisCache::GetEngineId("Mock 1.0"),
+        depth_, evaluation));
+  }
+  remove(filename);
+}
+
+TEST_F(ChessEngineInterfaceTest, MatingGame) {
+  ofstream pgn_file(pgn_);
+  pgn_file << "[Event \"test\"]" << endl << endl;
+  pgn_file << "1. f3 e5 2. g4 Qh4# 0-1" << endl;
+  pgn_file.close();
+
+  // the engine only sends "info depth 0 score mate 0" after the mate
+  ChessEngineInterface engine(engine_path_);
+  GameAnalysis analysis = AnalyzeGame(engine);
+  ASSERT_EQ(4U, analysis.moves.size());
+  const MoveAnalysis & mate = analysis.moves[3];
+  ASSERT_TRUE(mate.played.is_valid);
+  ASSERT_EQ(-MATE_SCORE, mate.played.score);
+  ASSERT_EQ(0, mate.played.mate);
+  ASSERT_EQ("", mate.played.best);
+  ASSERT_FALSE(mate.is_blunder);
+
+  // stalemate
+  Evaluation evaluation = engine.Analyze("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", depth_);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ(0, evaluation.score);
+  ASSERT_EQ("", evaluation.best);
+}
+
+TEST_F(ChessEngineInterfaceTest, BoundScores) {
+  // the last depths fail high, the last exact score is the result
+  setenv("MOCK_UCI_LOWERBOUND", "4", 1);
+  ChessEngineInterface engine(engine_path_);
+  Evaluation evaluation = engine.Analyze(START_FEN, depth_);
+  ASSERT_EQ(35, evaluation.score);
+  ASSERT_EQ(3, evaluation.depth);
+  ASSERT_FALSE(evaluation.is_bound);
+
+  // only bounds, the last one is kept but marked
+  setenv("MOCK_UCI_LOWERBOUND", "1", 1);
+  ChessEngineInterface bound_engine(engine_path_);
+  evaluation = bound_engine.Analyze(START_FEN, depth_);
+  ASSERT_EQ(85, evaluation.score);
+  ASSERT_EQ(5, evaluation.depth);
+  ASSERT_TRUE(evaluation.is_bound);
+}
+
+TEST_F(ChessEngineInterfaceTest, FaultyEngine) {
+  setenv("MOCK_UCI_GARBAGE", "1", 1);
+  setenv("MOCK_UCI_START_DELAY_MS", "100", 1);
+  ChessEngineInterface engine(engine_path_);
+  Evaluation evaluation = engine.Analyze(START_FEN, depth_);
+  ASSERT_EQ(35, evaluation.score);
+  ASSERT_EQ("e2e4 e7e5", evaluation.line);
+}
+
+TEST_F(ChessEngineInterfaceTest, Restart) {
+  // every second search of each process crashes, and is repeated
+  setenv("MOCK_UCI_CRASH_AFTER", "2", 1);
+  ChessEngineInterface engine(engine_path_);
+  for(int i = 0; i < 4; ++i) {
+    Evaluation evaluation = engine.Analyze(START_FEN, depth_);
+    ASSERT_TRUE(evaluation.is_valid);
+    ASSERT_EQ(35, evaluation.score);
+  }
+  ASSERT_EQ(3, engine.GetNumRestarts());
+  unsetenv("MOCK_UCI_CRASH_AFTER");
+
+  // a hung engine is killed once it does not answer the stop
+  setenv("MOCK_UCI_HANG_AFTER", "1", 1);
+  EngineOptions options;
+  options.search_timeout_ms = 100;
+  ChessEngineInterface hung_engine(engine_path_, false, options);
+  unsetenv("MOCK_UCI_HANG_AFTER");
+  Evaluation evaluation = hung_engine.Analyze(START_FEN, depth_);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ("e2e4 e7e5", evaluation.line);
+  ASSERT_EQ(1, hung_engine.GetNumRestarts());
+
+  // without a search timeout, the engine stops answering isready
+  setenv("MOCK_UCI_HANG_AFTER", "1", 1);
+  EngineOptions silence;
+  silence.silence_timeout_ms = 100;
+  ChessEngineInterface silent_engine(engine_path_, false, silence);
+  unsetenv("MOCK_UCI_HANG_AFTER");
+  evaluation = silent_engine.Analyze(START_FEN, depth_);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ(1, silent_engine.GetNumRestarts());
+
+  // a slow engine answers isready while it searches
+  setenv("MOCK_UCI_LATENCY_MS", "200", 1);
+  ChessEngineInterface slow_engine(engine_path_, false, silence);
+  depth_.depth = 3;
+  evaluation = slow_engine.Analyze(START_FEN, depth_);
+  ASSERT_EQ(3, evaluation.depth);
+  ASSERT_EQ(0, slow_engine.GetNumRestarts());
+}
+
+TEST_F(ChessEngineInterfaceTest, MissingEngine) {
+  ChessEngineInterface engine("/nonexistent/engine");
+  ASSERT_FALSE(engine.IsRunning());
+  ASSERT_FALSE(engine.Analyze(START_FEN, depth_).is_valid);
+}
+
+TEST_F(ChessEngineInterfaceTest, Pool) {
+  EnginePool pool(engine_path_, 3);
+  for(int i = 0; i < 20; ++i) {
+    pool.AddPosition(START_FEN, depth_);
+  }
+  PGNDatabase database(pgn_);
+  pool.AddGame(PGNReader(*database.begin()), true, false, depth_, 50);
+  auto results = pool.Wait();
+
+  ASSERT_EQ(21U, results.size());
+  for(int i = 0; i < 20; ++i) {
+    ASSERT_EQ(35, results[i].position.score);
+  }
+  ASSERT_EQ(5U, results[20].moves.size());
+  ASSERT_EQ(35, results[20].moves[0].best.score);
+}
+
+TEST_F(ChessEngineInterfaceTest, Submit) {
+  EnginePool pool(engine_path_, 2);
+  atomic<int> num_infos(0);
+  atomic<int> last_depth(0);
+  auto position = pool.Submit(START_FEN, depth_, [&](const UCIInfo & info) {
+    num_infos++;
+    last_depth = info.depth;
+  });
+  PGNDatabase database(pgn_);
+  auto game = pool.Submit(PGNReader(*database.begin()), true, true, depth_, 50);
+  size_t index = pool.AddPosition(START_FEN, depth_);
+
+  Evaluation evaluation = position.get();
+  ASSERT_EQ(35, evaluation.score);
+  ASSERT_EQ("e2e4 e7e5", evaluation.line);
+  // an info line for each depth
+  ASSERT_EQ(5, num_infos);
+  ASSERT_EQ(5, last_depth);
+  ASSERT_EQ(10U, game.get().moves.size());
+
+  // submitted jobs are not in the results
+  ASSERT_EQ(0U, index);
+  auto results = pool.Wait();
+  ASSERT_EQ(1U, results.size());
+  ASSERT_EQ(35, results[0].position.score);
+}
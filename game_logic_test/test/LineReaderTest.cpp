@@ -0,0 +1,122 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "LineReader.h"
+#include <unistd.h>
+#include <cstring>
+#include <thread>
+
+using namespace std;
+using namespace acortes::chess;
+
+class LineReaderTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    for(int i = 0; i < NUM_PIPES; ++i) {
+      ASSERT_EQ(0, pipe(pipes_[i]));
+      readers_[i].SetFd(pipes_[i][0]);
+    }
+  }
+
+  virtual void TearDown() {
+    for(int i = 0; i < NUM_PIPES; ++i) {
+      close(pipes_[i][0]);
+      if(pipes_[i][1] != -1) {
+        close(pipes_[i][1]);
+      }
+    }
+  }
+
+  void Write(int i, const char * text) {
+    ASSERT_EQ(static_cast<ssize_t>(strlen(text)), write(pipes_[i][1], text, strlen(text)));
+  }
+
+  static const int NUM_PIPES = 3;
+  int pipes_[NUM_PIPES][2];
+  LineReader readers_[NUM_PIPES];
+};
+
+TEST_F(LineReaderTest, PartialLines) {
+  TextSpan line;
+  Write(0, "info depth 1");
+  ASSERT_FALSE(readers_[0].WaitForLine(10));
+  Write(0, " score cp 20\nbest");
+  ASSERT_TRUE(readers_[0].WaitForLine(10));
+  ASSERT_TRUE(readers_[0].GetLine(line));
+  ASSERT_EQ("info depth 1 score cp 20", line.ToString());
+  ASSERT_FALSE(readers_[0].GetLine(line));
+  Write(0, "move e2e4\n\n");
+  ASSERT_TRUE(readers_[0].WaitForLine(10));
+  ASSERT_TRUE(readers_[0].GetLine(line));
+  ASSERT_EQ("bestmove e2e4", line.ToString());
+  ASSERT_TRUE(readers_[0].GetLine(line));
+  ASSERT_TRUE(line.Empty());
+}
+
+TEST_F(LineReaderTest, BlocksUntilData) {
+  thread writer([this]() {
+    this_thread::sleep_for(chrono::milliseconds(20));
+    Write(1, "readyok\n");
+  });
+  ASSERT_TRUE(readers_[1].WaitForLine());
+  writer.join();
+  TextSpan line;
+  ASSERT_TRUE(readers_[1].GetLine(line));
+  ASSERT_EQ("readyok", line.ToString());
+}
+
+// more output than the buffer holds, read while it is written
+TEST_F(LineReaderTest, ConstantMemory) {
+  string info = "info depth 20 score cp 13 pv e2e4 e7e5 g1f3 b8c6\n";
+  size_t num_lines = 4 * LineReader::BUFFER_SIZE / info.size();
+  thread writer([&]() {
+    for(size_t i = 0; i < num_lines; ++i) {
+      Write(2, info.c_str());
+    }
+  });
+
+  TextSpan line;
+  for(size_t i = 0; i < num_lines; ++i) {
+    ASSERT_TRUE(readers_[2].WaitForLine(1000));
+    ASSERT_TRUE(readers_[2].GetLine(line));
+    ASSERT_EQ(info.substr(0, info.size() - 1), line.ToString());
+  }
+  writer.join();
+}
+
+// lines that do not fit in the buffer are dropped
+TEST_F(LineReaderTest, LongLine) {
+  string long_line(LineReader::BUFFER_SIZE + 100, 'x');
+  thread writer([&]() {
+    Write(0, long_line.c_str());
+    Write(0, "\nbestmove e2e4\n");
+  });
+
+  TextSpan line;
+  ASSERT_TRUE(readers_[0].WaitForLine(1000));
+  ASSERT_TRUE(readers_[0].GetLine(line));
+  ASSERT_EQ("bestmove e2e4", line.ToString());
+  writer.join();
+}
+
+TEST_F(LineReaderTest, Multiplex) {
+  vector<LineReader *> readers = {&readers_[0], &readers_[1], &readers_[2]};
+  ASSERT_EQ(0, LineReader::Wait(readers, 10));
+
+  Write(2, "uciok\n");
+  ASSERT_EQ(1, LineReader::Wait(readers, 10));
+  ASSERT_TRUE(readers_[2].HasLine());
+  Write(0, "readyok\n");
+  ASSERT_EQ(2, LineReader::Wait(readers, 10));
+
+  // closed pipes do not block
+  close(pipes_[1][1]);
+  pipes_[1][1] = -1;
+  readers = {&readers_[1]};
+  ASSERT_EQ(0, LineReader::Wait(readers));
+  ASSERT_TRUE(readers_[1].IsClosed());
+}
@@ -0,0 +1,106 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "MoveGenerator.h"
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+using namespace acortes::chess;
+
+class MoveGeneratorTest : public ::testing::TestWithParam<pair<string,size_t>> {
+};
+
+// number of legal moves in well known positions
+TEST_P(MoveGeneratorTest, CountMoves) {
+  Board board(8,8);
+  MoveList moves;
+  ASSERT_TRUE(board.LoadFEN(GetParam().first));
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  ASSERT_EQ(GetParam().second, moves.Size());
+}
+
+INSTANTIATE_TEST_CASE_P(
+    KnownPositions,
+    MoveGeneratorTest,
+    ::testing::Values(
+        make_pair("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 20),
+        make_pair("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 48),
+        make_pair("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 14),
+        make_pair("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 6),
+        make_pair("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 44),
+        make_pair("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 46)));
+
+static bool Contains(const MoveList & moves, const string & uci) {
+  return find_if(moves.begin(), moves.end(), [&uci](PackedMove m) {
+    return m.UCI() == uci; }) != moves.end();
+}
+
+TEST(MoveGeneratorSpecialMoves, EnPassant) {
+  Board board(8,8);
+  MoveList moves;
+  board.LoadFEN("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3");
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  ASSERT_TRUE(Contains(moves, "e5f6"));
+  ASSERT_FALSE(Contains(moves, "e5d6"));
+}
+
+TEST(MoveGeneratorSpecialMoves, EnPassantExposesKing) {
+  // capturing would leave both pawns off the fifth rank
+  Board board(8,8);
+  MoveList moves;
+  board.LoadFEN("8/8/8/KPp4r/8/8/8/7k w - c6 0 2");
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  ASSERT_FALSE(Contains(moves, "b5c6"));
+  ASSERT_EQ(4u, moves.Size());
+}
+
+TEST(MoveGeneratorSpecialMoves, Promotions) {
+  Board board(8,8);
+  MoveList moves;
+  board.LoadFEN("1n5k/P7/8/8/8/8/8/7K w - - 0 1");
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  ASSERT_TRUE(Contains(moves, "a7a8q"));
+  ASSERT_TRUE(Contains(moves, "a7a8n"));
+  ASSERT_TRUE(Contains(moves, "a7b8r"));
+  ASSERT_TRUE(Contains(moves, "a7b8b"));
+  // 8 promotions plus 3 king moves
+  ASSERT_EQ(11u, moves.Size());
+}
+
+TEST(MoveGeneratorSpecialMoves, CastlingThroughCheck) {
+  // f1 is attacked by the bishop, only the long castle is allowed
+  Board board(8,8);
+  MoveList moves;
+  board.LoadFEN("r3k2r/8/8/8/2b5/8/8/R3K2R w KQkq - 0 1");
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  ASSERT_FALSE(Contains(moves, "e1g1"));
+  ASSERT_TRUE(Contains(moves, "e1c1"));
+}
+
+TEST(MoveGeneratorSpecialMoves, PinnedPiece) {
+  // the e2 knight is pinned by the e8 rook
+  Board board(8,8);
+  MoveList moves;
+  board.LoadFEN("4r2k/8/8/8/8/8/4N3/4K3 w - - 0 1");
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  for(const auto & move : moves) {
+    ASSERT_NE(GetSquare(4, 1), move.GetFrom());
+  }
+}
+
+TEST(MoveGeneratorSpecialMoves, DoubleCheck) {
+  Board board(8,8);
+  MoveList moves;
+  board.LoadFEN("4r2k/8/8/8/8/5n2/3Q4/4K3 w - - 0 1");
+  ASSERT_TRUE(MoveGenerator::IsInCheck(board));
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  for(const auto & move : moves) {
+    ASSERT_EQ(GetSquare(4, 0), move.GetFrom());
+  }
+}
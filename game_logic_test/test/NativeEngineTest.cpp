@@ -0,0 +1,137 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "NativeEngine.h"
+#include <algorithm>
+
+using namespace std;
+using namespace acortes::chess;
+
+class NativeEngineTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    depth_.depth = 4;
+  }
+
+  NativeEngine engine_;
+  SearchLimits depth_;
+};
+
+TEST_F(NativeEngineTest, Evaluate) {
+  Board board(8,8);
+  ASSERT_TRUE(board.LoadFEN(START_FEN));
+  ASSERT_EQ(0, NativeEngine::Evaluate(board));
+  // a queen up, from the side to move
+  ASSERT_TRUE(board.LoadFEN("3qk3/8/8/8/8/8/8/4K3 w - - 0 1"));
+  ASSERT_GT(-800, NativeEngine::Evaluate(board));
+  ASSERT_TRUE(board.LoadFEN("3qk3/8/8/8/8/8/8/4K3 b - - 0 1"));
+  ASSERT_LT(800, NativeEngine::Evaluate(board));
+}
+
+TEST_F(NativeEngineTest, Material) {
+  // the queen is taken by either side, scores from the light side
+  Evaluation evaluation = engine_.Analyze("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1", depth_);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ("d1d5", evaluation.best);
+  ASSERT_LT(300, evaluation.score);
+  ASSERT_EQ(0, evaluation.mate);
+  ASSERT_EQ(4, evaluation.depth);
+  ASSERT_EQ(0U, evaluation.line.find("d1d5 "));
+
+  evaluation = engine_.Analyze("4k3/8/8/3Q4/8/8/8/3rK3 b - - 0 1", depth_);
+  ASSERT_EQ("d1d5", evaluation.best);
+  ASSERT_GT(-300, evaluation.score);
+}
+
+TEST_F(NativeEngineTest, Mates) {
+  Evaluation evaluation = engine_.Analyze("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", depth_);
+  ASSERT_EQ("a1a8", evaluation.best);
+  ASSERT_EQ(1, evaluation.mate);
+  ASSERT_EQ(GetMateScore(1), evaluation.score);
+
+  // mated after any move
+  evaluation = engine_.Analyze("1r4k1/5ppp/8/8/8/8/r7/6K1 w - - 0 1", depth_);
+  ASSERT_EQ(-1, evaluation.mate);
+  ASSERT_EQ(GetMateScore(-1), evaluation.score);
+  evaluation = engine_.Analyze("r5k1/5ppp/8/8/8/8/1R3PPP/1R4K1 w - - 0 1", depth_);
+  ASSERT_EQ(2, evaluation.mate);
+  evaluation = engine_.Analyze("r5k1/5ppp/8/8/8/8/1R3PPP/1R4K1 b - - 0 1", depth_);
+  ASSERT_EQ(0, evaluation.mate);
+}
+
+TEST_F(NativeEngineTest, NoMoves) {
+  // stalemate and checkmate
+  Evaluation evaluation = engine_.Analyze("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", depth_);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ(0, evaluation.score);
+  ASSERT_EQ("", evaluation.best);
+  evaluation = engine_.Analyze("7k/6Q1/6K1/8/8/8/8/8 b - - 0 1", depth_);
+  ASSERT_EQ(MATE_SCORE, evaluation.score);
+  ASSERT_EQ(0, evaluation.mate);
+
+  ASSERT_FALSE(engine_.Analyze("not a position", depth_).is_valid);
+}
+
+TEST_F(NativeEngineTest, Limits) {
+  SearchLimits nodes;
+  nodes.nodes = 5000;
+  Evaluation evaluation = engine_.Analyze(START_FEN, nodes);
+  ASSERT_LE(1, evaluation.depth);
+  ASSERT_GE(5000U, evaluation.nodes);
+  ASSERT_FALSE(evaluation.best.empty());
+
+  SearchLimits movetime;
+  movetime.movetime_ms = 100;
+  evaluation = engine_.Analyze(START_FEN, movetime);
+  ASSERT_LE(100, evaluation.time_ms);
+  ASSERT_GT(300, evaluation.time_ms);
+
+  int num_infos = 0;
+  engine_.SetInfoCallback([&](const UCIInfo & info) {
+    num_infos++;
+    ASSERT_EQ(num_infos, info.depth);
+  });
+  evaluation = engine_.Analyze(START_FEN, depth_);
+  ASSERT_EQ(4, num_infos);
+}
+
+TEST_F(NativeEngineTest, LongVariation) {
+  // a pawn endgame deep enough for variations longer than an info holds
+  SearchLimits limits;
+  limits.depth = 34;
+  string pv;
+  engine_.SetInfoCallback([&](const UCIInfo & info) {
+    ASSERT_GE(UCIInfo::MAX_PV_LENGTH, info.pv_length);
+    pv.clear();
+    for(size_t i = 0; i < info.pv_length; ++i) {
+      pv += (i > 0) ? " " + info.pv[i].UCI() : info.pv[i].UCI();
+    }
+  });
+  Evaluation evaluation = engine_.Analyze("8/8/4k3/8/8/8/4P3/4K3 w - - 0 1", limits);
+  ASSERT_EQ(34, evaluation.depth);
+  // the evaluation keeps the whole variation
+  ASSERT_EQ(0U, evaluation.line.find(pv));
+  size_t num_moves = count(evaluation.line.begin(), evaluation.line.end(), ' ') + 1;
+  ASSERT_LT(UCIInfo::MAX_PV_LENGTH, num_moves);
+}
+
+TEST_F(NativeEngineTest, Threads) {
+  NativeEngine engine(16, 4);
+  Evaluation evaluation = engine.Analyze("r5k1/5ppp/8/8/8/8/1R3PPP/1R4K1 w - - 0 1", depth_);
+  ASSERT_TRUE(evaluation.is_valid);
+  ASSERT_EQ(2, evaluation.mate);
+
+  // helpers keep searching until the main thread is done, their nodes
+  // are counted
+  SearchLimits movetime;
+  movetime.movetime_ms = 100;
+  evaluation = engine.Analyze(START_FEN, movetime);
+  ASSERT_GT(300, evaluation.time_ms);
+  ASSERT_LT(0U, evaluation.nodes);
+  ASSERT_FALSE(evaluation.best.empty());
+}
@@ -0,0 +1,87 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "PGNDatabase.h"
+#include "PGNReader.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+using namespace acortes::chess;
+
+class PGNDatabaseTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    ofstream pgn_file(filename_);
+    pgn_file << "[Event \"First\"]" << endl;
+    pgn_file << "[White \"Player, \\\"One\\\"\"]" << endl;
+    pgn_file << "[Result \"1-0\"]" << endl;
+    pgn_file << endl;
+    pgn_file << "1. e4 {best by test} e5 2. Nf3 (2. f4 exf4 (2... d5)) Nc6 $1" << endl;
+    pgn_file << "3. Bb5 a6 1-0" << endl;
+    pgn_file << endl;
+    pgn_file << "[Event \"Second\"]" << endl;
+    pgn_file << endl;
+    pgn_file << "1.d4 d5 2.c4 ; queen's gambit" << endl;
+    pgn_file << "e6 1/2-1/2" << endl;
+    pgn_file << "[Event \"Third\"]" << endl;
+    pgn_file << "1. Nf3 Nf6 2. g3 g6 3. Bg2 Bg7 4. 0-0 O-O" << endl;
+    pgn_file << "[Event \"Fourth\"]" << endl;
+    pgn_file << "1. e4 c5 *" << endl;
+    pgn_file.close();
+  }
+
+  virtual void TearDown() {
+    remove(filename_.c_str());
+  }
+
+  string filename_ = "test_database.pgn";
+};
+
+TEST_F(PGNDatabaseTest, Games) {
+  PGNDatabase database(filename_);
+  ASSERT_TRUE(database.IsOpen());
+
+  vector<string> events;
+  for(const auto & game : database) {
+    events.push_back(game.GetTag("Event").ToString());
+  }
+  ASSERT_EQ((vector<string>{"First", "Second", "Third", "Fourth"}), events);
+
+  auto game = database.begin();
+  ASSERT_EQ(3U, game->tags.size());
+  ASSERT_TRUE(game->GetTag("White") == "Player, \\\"One\\\"");
+  ASSERT_TRUE(game->GetTag("Black").Empty());
+  ASSERT_EQ("1. e4 {best by test} e5 2. Nf3 (2. f4 exf4 (2... d5)) Nc6 $1\n"
+            "3. Bb5 a6 1-0", game->movetext.ToString());
+}
+
+TEST_F(PGNDatabaseTest, Moves) {
+  PGNDatabase database(filename_);
+  vector<vector<string>> moves = {
+      {"e4", "e5", "Nf3", "Nc6", "Bb5", "a6"},
+      {"d4", "d5", "c4", "e6"},
+      {"Nf3", "Nf6", "g3", "g6", "Bg2", "Bg7", "0-0", "O-O"},
+      {"e4", "c5"}};
+
+  size_t n = 0;
+  for(const auto & game : database) {
+    PGNReader reader(game, true);
+    ASSERT_EQ(moves[n].size(), reader.GetNumMoves());
+    for(size_t i = 0; i < moves[n].size(); ++i) {
+      ASSERT_EQ(moves[n][i], reader.GetSAN(i));
+    }
+    n++;
+  }
+  ASSERT_EQ(moves.size(), n);
+}
+
+TEST(PGNDatabaseOpenTest, MissingFile) {
+  PGNDatabase database("missing_file.pgn");
+  ASSERT_FALSE(database.IsOpen());
+  ASSERT_TRUE(database.begin() == database.end());
+}
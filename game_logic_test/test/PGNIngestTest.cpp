@@ -0,0 +1,73 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "PGNDatabase.h"
+#include "PGNIngest.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+using namespace acortes::chess;
+
+class PGNIngestTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    ofstream pgn_file(filename_);
+    for(int i = 0; i < NUM_GAMES; ++i) {
+      pgn_file << "[Event \"" << i << "\"]" << endl;
+      pgn_file << "[Result \"*\"]" << endl;
+      pgn_file << endl;
+      // odd games have an illegal move
+      pgn_file << "1. e4 e5 2. Nf3 " << ((i % 2) ? "Ke3" : "Nc6") << " *" << endl;
+      pgn_file << endl;
+    }
+    pgn_file.close();
+  }
+
+  virtual void TearDown() {
+    remove(filename_.c_str());
+  }
+
+  static const int NUM_GAMES = 100;
+  string filename_ = "test_ingest.pgn";
+};
+
+TEST_F(PGNIngestTest, Split) {
+  PGNDatabase database(filename_);
+  ASSERT_TRUE(database.IsOpen());
+  auto chunks = PGNIngest::Split(database.GetData(), database.GetSize(), 7);
+  ASSERT_EQ(7U, chunks.size());
+
+  // chunks start at a game and cover the whole file
+  const char * next = database.GetData();
+  for(const auto & chunk : chunks) {
+    ASSERT_EQ(next, chunk.data);
+    ASSERT_EQ("[Event", string(chunk.data, 6));
+    next = chunk.data + chunk.size;
+  }
+  ASSERT_EQ(database.GetData() + database.GetSize(), next);
+}
+
+TEST_F(PGNIngestTest, GamesInOrder) {
+  PGNDatabase database(filename_);
+  PGNIngest ingest(4);
+  vector<PGNGameSummary> games;
+  size_t num_games = ingest.Run(database, [&](const PGNGameSummary & game) {
+    games.push_back(game);
+  });
+
+  ASSERT_EQ(static_cast<size_t>(NUM_GAMES), num_games);
+  ASSERT_EQ(static_cast<size_t>(NUM_GAMES), games.size());
+  for(int i = 0; i < NUM_GAMES; ++i) {
+    ASSERT_EQ(static_cast<size_t>(i), games[i].index);
+    ASSERT_EQ(to_string(i), games[i].event);
+    ASSERT_EQ((i % 2) ? 3U : 4U, games[i].num_moves);
+    ASSERT_EQ((i % 2) ? 1U : 0U, games[i].num_errors);
+  }
+  ASSERT_EQ("r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+      games[0].final_fen);
+}
@@ -0,0 +1,65 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "Perft.h"
+#include <tuple>
+
+using namespace std;
+using namespace acortes::chess;
+
+// published node counts, depths are kept low so the test runs fast
+class PerftTest : public ::testing::TestWithParam<tuple<string,int,uint64_t>> {
+protected:
+  virtual void SetUp() {
+    board_ = new Board(8,8);
+    ASSERT_TRUE(board_->LoadFEN(get<0>(GetParam())));
+  }
+
+  virtual void TearDown() {
+    delete board_;
+  }
+
+  Board * board_;
+};
+
+TEST_P(PerftTest, Count) {
+  Perft perft;
+  ASSERT_EQ(get<2>(GetParam()), perft.Count(*board_, get<1>(GetParam())));
+}
+
+TEST_P(PerftTest, CountWithHash) {
+  Perft perft(16);
+  ASSERT_EQ(get<2>(GetParam()), perft.Count(*board_, get<1>(GetParam())));
+}
+
+TEST_P(PerftTest, DivideWithThreads) {
+  Perft perft(16);
+  uint64_t nodes = 0;
+  for(const auto & root : perft.Divide(*board_, get<1>(GetParam()), 4)) {
+    nodes += root.second;
+  }
+  ASSERT_EQ(get<2>(GetParam()), nodes);
+}
+
+TEST_P(PerftTest, BoardIsRestored) {
+  string fen = board_->FEN();
+  Perft perft;
+  perft.Count(*board_, 2);
+  ASSERT_EQ(fen, board_->FEN());
+}
+
+INSTANTIATE_TEST_CASE_P(
+    KnownPositions,
+    PerftTest,
+    ::testing::Values(
+        make_tuple("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4, 197281ULL),
+        make_tuple("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862ULL),
+        make_tuple("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624ULL),
+        make_tuple("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333ULL),
+        make_tuple("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 3, 62379ULL),
+        make_tuple("r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3, 89890ULL)));
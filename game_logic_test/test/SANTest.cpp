@@ -0,0 +1,75 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "SAN.h"
+#include <tuple>
+
+using namespace std;
+using namespace acortes::chess;
+
+// position, move in UCI notation and the same move in SAN
+class SANTest : public ::testing::TestWithParam<tuple<string,string,string>> {
+protected:
+  virtual void SetUp() {
+    board_ = new Board(8,8);
+    ASSERT_TRUE(board_->LoadFEN(get<0>(GetParam())));
+  }
+
+  virtual void TearDown() {
+    delete board_;
+  }
+
+  Board * board_;
+};
+
+TEST_P(SANTest, Parse) {
+  PackedMove move = SAN::Parse(*board_, get<2>(GetParam()));
+  ASSERT_FALSE(move.IsNull());
+  ASSERT_EQ(get<1>(GetParam()), move.UCI());
+}
+
+TEST_P(SANTest, Write) {
+  PackedMove move = SAN::Parse(*board_, get<2>(GetParam()));
+  ASSERT_EQ(get<2>(GetParam()), SAN::Write(*board_, move));
+}
+
+INSTANTIATE_TEST_CASE_P(
+    SpecialMoves,
+    SANTest,
+    ::testing::Values(
+        make_tuple("7k/8/8/8/8/8/8/R3K2R w KQ - 0 1", "e1g1", "O-O"),
+        make_tuple("7k/8/8/8/8/8/8/R4RK1 w - - 0 1", "a1d1", "Rad1"),
+        make_tuple("7k/8/8/R7/8/8/8/R5K1 w - - 0 1", "a1a3", "R1a3"),
+        make_tuple("k7/8/8/8/8/2Q1Q3/8/2Q3K1 w - - 0 1", "c3d2", "Qc3d2"),
+        make_tuple("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", "a1a8", "Ra8#"),
+        make_tuple("1r5k/P7/8/8/8/8/8/6K1 w - - 0 1", "a7b8q", "axb8=Q+"),
+        make_tuple("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", "exd6")));
+
+TEST(SANParseTest, AlternativeNotations) {
+  Board board(8,8);
+  ASSERT_TRUE(board.LoadFEN("r3k2r/P7/8/8/8/8/8/4K3 b kq - 0 1"));
+  ASSERT_EQ("e8c8", SAN::Parse(board, "0-0-0").UCI());
+  ASSERT_EQ("e8g8", SAN::Parse(board, "O-O+").UCI());
+  ASSERT_TRUE(board.LoadFEN("7k/P7/8/8/8/8/8/4K3 w - - 0 1"));
+  ASSERT_EQ("a7a8n", SAN::Parse(board, "a8N").UCI());
+  ASSERT_EQ("a7a8q", SAN::Parse(board, "a8=Q!").UCI());
+}
+
+TEST(SANParseTest, InvalidMoves) {
+  Board board(8,8);
+  ASSERT_TRUE(board.LoadFEN("7k/8/8/8/8/8/8/R4RK1 w - - 0 1"));
+  // ambiguous
+  ASSERT_TRUE(SAN::Parse(board, "Rd1").IsNull());
+  // illegal
+  ASSERT_TRUE(SAN::Parse(board, "Rb2").IsNull());
+  ASSERT_TRUE(SAN::Parse(board, "O-O").IsNull());
+  // not a move
+  ASSERT_TRUE(SAN::Parse(board, "1/2-1/2").IsNull());
+  ASSERT_TRUE(SAN::Parse(board, "*").IsNull());
+  ASSERT_TRUE(SAN::Parse(board, "").IsNull());
+}
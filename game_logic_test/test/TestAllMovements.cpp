@@ -54,7 +54,7 @@ TEST_P(TestAllMovements, Test) {
   pgn_file.close();
 
   // initialize all variables
-  pgn_ = new PGNReader(filename);
+  pgn_ = new PGNReader(filename, true);
   player1_ = new PGNPlayer(Color::Light, pgn_);
   player2_ = new PGNPlayer(Color::Dark, pgn_);
   game_ = new Game(board_, player1_, player2_);
@@ -64,11 +64,27 @@ TEST_P(TestAllMovements, Test) {
   ASSERT_EQ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", game_->FEN());
 
   // validate all movements
+  ASSERT_EQ(movements.size(), pgn_->GetNumMoves());
   for(const auto & move : movements) {
     game_->Move();
     cout << move.first << " --> " << game_->FEN() << endl;
     ASSERT_EQ(move.second, game_->FEN());
+    // some movements are written with their number
+    string san = move.first.substr(move.first.find('.') + 1);
+    ASSERT_EQ(san, game_->GetLastMove());
+    ASSERT_EQ(san, pgn_->GetSAN(game_->GetNumMoves() - 1));
+    ASSERT_EQ(board_->ComputeKey(), game_->GetKey());
   }
+
+  // take back all movements
+  for(size_t i = movements.size() - 1; i > 0; --i) {
+    game_->UnmakeMove();
+    ASSERT_EQ(movements[i - 1].second, game_->FEN());
+    ASSERT_EQ(board_->ComputeKey(), game_->GetKey());
+  }
+  game_->UnmakeMove();
+  ASSERT_EQ("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", game_->FEN());
+  ASSERT_TRUE(game_->UnmakeMove().IsNull());
 };
 
 vector<pair<string,string>> Game001 = {
@@ -431,8 +447,23 @@ vector<pair<string,string>> Game004 = {
     make_pair("Kf6","r7/pb6/2nPBkpB/1p6/2p5/2P2rP1/8/2K4R w - - 4 33"),
 };
 
+// en passant capture and promotion, the promoted queen moves later
+vector<pair<string,string>> Game005 = {
+    make_pair("e4", "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1"),
+    make_pair("d5", "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2"),
+    make_pair("exd5", "rnbqkbnr/ppp1pppp/8/3P4/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2"),
+    make_pair("c5", "rnbqkbnr/pp2pppp/8/2pP4/8/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 3"),
+    make_pair("dxc6", "rnbqkbnr/pp2pppp/2P5/8/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 3"),
+    make_pair("Nf6", "rnbqkb1r/pp2pppp/2P2n2/8/8/8/PPPP1PPP/RNBQKBNR w KQkq - 1 4"),
+    make_pair("cxb7", "rnbqkb1r/pP2pppp/5n2/8/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 4"),
+    make_pair("Nbd7", "r1bqkb1r/pP1npppp/5n2/8/8/8/PPPP1PPP/RNBQKBNR w KQkq - 1 5"),
+    make_pair("bxa8=Q", "Q1bqkb1r/p2npppp/5n2/8/8/8/PPPP1PPP/RNBQKBNR b KQk - 0 5"),
+    make_pair("e5", "Q1bqkb1r/p2n1ppp/5n2/4p3/8/8/PPPP1PPP/RNBQKBNR w KQk e6 0 6"),
+    make_pair("Qxa7", "2bqkb1r/Q2n1ppp/5n2/4p3/8/8/PPPP1PPP/RNBQKBNR b KQk - 0 6")
+};
+
 INSTANTIATE_TEST_CASE_P(
     AllGames,
     TestAllMovements,
-    ::testing::Values(Game001, Game002, Game003, Game004));
+    ::testing::Values(Game001, Game002, Game003, Game004, Game005));
 
@@ -0,0 +1,94 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "TranspositionTable.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace acortes::chess;
+
+TEST(TranspositionTableTest, StoredAndFound) {
+  TranspositionTable table(1);
+  ASSERT_EQ(1024U * 1024 / 16, table.GetNumEntries());
+  TranspositionTable::Entry entry;
+  ASSERT_FALSE(table.Probe(0x1234, entry));
+
+  PackedMove move(12, 28, PackedMove::DOUBLE_PAWN_PUSH);
+  table.Store(0x1234, move, -99980, 7, TranspositionTable::UPPER_BOUND);
+  ASSERT_TRUE(table.Probe(0x1234, entry));
+  ASSERT_EQ(move, entry.move);
+  ASSERT_EQ(-99980, entry.score);
+  ASSERT_EQ(7, entry.depth);
+  ASSERT_EQ(TranspositionTable::UPPER_BOUND, entry.bound);
+
+  // without a move the one stored is kept
+  table.Store(0x1234, PackedMove(), 35, 8, TranspositionTable::EXACT);
+  ASSERT_TRUE(table.Probe(0x1234, entry));
+  ASSERT_EQ(move, entry.move);
+  ASSERT_EQ(35, entry.score);
+
+  table.Clear();
+  ASSERT_FALSE(table.Probe(0x1234, entry));
+}
+
+TEST(TranspositionTableTest, Replacement) {
+  TranspositionTable table(1, true);
+  size_t num_buckets = table.GetNumEntries() / TranspositionTable::BUCKET_SIZE;
+  // keys of the same bucket, the shallowest is replaced
+  for(uint64_t i = 1; i <= TranspositionTable::BUCKET_SIZE; ++i) {
+    table.Store(i * num_buckets, PackedMove(), 0, 10 + i, TranspositionTable::EXACT);
+  }
+  table.Store(100 * num_buckets, PackedMove(), 0, 1, TranspositionTable::EXACT);
+  TranspositionTable::Entry entry;
+  ASSERT_FALSE(table.Probe(num_buckets, entry));
+  ASSERT_TRUE(table.Probe(2 * num_buckets, entry));
+  ASSERT_TRUE(table.Probe(100 * num_buckets, entry));
+
+  // entries of older searches count as shallower, the deeper one of
+  // the current search is kept
+  table.NewSearch();
+  ASSERT_EQ(0, table.GetHashfull());
+  table.Store(101 * num_buckets, PackedMove(), 0, 10, TranspositionTable::EXACT);
+  table.Store(102 * num_buckets, PackedMove(), 0, 10, TranspositionTable::EXACT);
+  ASSERT_FALSE(table.Probe(100 * num_buckets, entry));
+  ASSERT_FALSE(table.Probe(2 * num_buckets, entry));
+  ASSERT_TRUE(table.Probe(3 * num_buckets, entry));
+  ASSERT_TRUE(table.Probe(101 * num_buckets, entry));
+  ASSERT_TRUE(table.Probe(102 * num_buckets, entry));
+  ASSERT_LT(0, table.GetHashfull());
+}
+
+// threads writing the same buckets never read an entry of another key
+TEST(TranspositionTableTest, SharedByThreads) {
+  TranspositionTable table(1);
+  size_t num_buckets = table.GetNumEntries() / TranspositionTable::BUCKET_SIZE;
+  vector<thread> threads;
+  vector<int> num_errors(4, 0);
+  for(int t = 0; t < 4; ++t) {
+    threads.push_back(thread([&, t]() {
+      mt19937_64 random(t);
+      TranspositionTable::Entry entry;
+      for(int i = 0; i < 200000; ++i) {
+        // few buckets, so writes collide
+        uint64_t key = (random() % 64) * num_buckets + random() % 4;
+        int score = static_cast<int>(key % 1000);
+        if(table.Probe(key, entry) && (entry.score != score || entry.depth != score % 64)) {
+          num_errors[t]++;
+        }
+        table.Store(key, PackedMove(), score, score % 64, TranspositionTable::EXACT);
+      }
+    }));
+  }
+  for(auto & t : threads) {
+    t.join();
+  }
+  for(int errors : num_errors) {
+    ASSERT_EQ(0, errors);
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "UCIInfo.h"
+#include <cstring>
+
+using namespace std;
+using namespace acortes::chess;
+
+class UCIInfoTest : public ::testing::Test {
+protected:
+  bool Parse(const char * line) {
+    return info_.Parse(TextSpan(line, strlen(line)));
+  }
+
+  string GetPV() {
+    string pv;
+    for(size_t i = 0; i < info_.pv_length; ++i) {
+      pv += (i > 0) ? " " + info_.pv[i].UCI() : info_.pv[i].UCI();
+    }
+    return pv;
+  }
+
+  UCIInfo info_;
+};
+
+TEST_F(UCIInfoTest, AllFields) {
+  ASSERT_TRUE(Parse("info depth 24 seldepth 33 multipv 1 score cp -17 nodes 5219021 "
+                    "nps 1702000 hashfull 812 tbhits 0 time 3066 pv e7e5 g1f3 b8c6"));
+  ASSERT_EQ(24, info_.depth);
+  ASSERT_EQ(33, info_.seldepth);
+  ASSERT_EQ(1, info_.multipv);
+  ASSERT_TRUE(info_.has_score);
+  ASSERT_FALSE(info_.is_mate);
+  ASSERT_EQ(-17, info_.score);
+  ASSERT_EQ(UCIInfo::Bound::Exact, info_.bound);
+  ASSERT_EQ(5219021U, info_.nodes);
+  ASSERT_EQ(1702000U, info_.nps);
+  ASSERT_EQ(812, info_.hashfull);
+  ASSERT_EQ(3066, info_.time_ms);
+  ASSERT_EQ("e7e5 g1f3 b8c6", GetPV());
+}
+
+TEST_F(UCIInfoTest, MateAndBounds) {
+  ASSERT_TRUE(Parse("info depth 30 score mate -4 pv h7h8 g6h6"));
+  ASSERT_TRUE(info_.has_score);
+  ASSERT_TRUE(info_.is_mate);
+  ASSERT_EQ(-4, info_.score);
+
+  ASSERT_TRUE(Parse("info depth 12 score cp 40 lowerbound nodes 100 pv d2d4"));
+  ASSERT_EQ(UCIInfo::Bound::Lower, info_.bound);
+  ASSERT_EQ(40, info_.score);
+  ASSERT_EQ(100U, info_.nodes);
+  ASSERT_TRUE(Parse("info depth 12 score cp 30 upperbound"));
+  ASSERT_EQ(UCIInfo::Bound::Upper, info_.bound);
+  ASSERT_EQ(0U, info_.pv_length);
+}
+
+TEST_F(UCIInfoTest, OtherLines) {
+  // fields are reset from one line to the next
+  ASSERT_TRUE(Parse("info depth 5 currmove e2e4 currmovenumber 1"));
+  ASSERT_EQ(5, info_.depth);
+  ASSERT_FALSE(info_.has_score);
+  ASSERT_TRUE(Parse("info string NNUE evaluation using nn.nnue depth 99"));
+  ASSERT_EQ(0, info_.depth);
+  ASSERT_FALSE(Parse("bestmove e2e4 ponder e7e5"));
+  ASSERT_FALSE(Parse("information"));
+  ASSERT_TRUE(Parse("info depth x score cp abc pv zz e2e4 e7e9 a7a8k a7a8q"));
+  ASSERT_EQ(0, info_.depth);
+  ASSERT_EQ("e2e4 a7a8q", GetPV());
+  ASSERT_TRUE(Parse("info score cp"));
+  ASSERT_FALSE(info_.has_score);
+}
+
+TEST_F(UCIInfoTest, PVBeforeOtherFields) {
+  ASSERT_TRUE(Parse("info pv g1f3 d7d5 score cp 12 depth 3"));
+  ASSERT_EQ("g1f3 d7d5", GetPV());
+  ASSERT_EQ(12, info_.score);
+  ASSERT_EQ(3, info_.depth);
+
+  // long lines are cut
+  string line = "info pv";
+  for(int i = 0; i < 40; ++i) {
+    line += (i % 2) ? " g8f6 f6g8" : " g1f3 f3g1";
+  }
+  ASSERT_TRUE(Parse(line.c_str()));
+  ASSERT_EQ(UCIInfo::MAX_PV_LENGTH, info_.pv_length);
+}
+
+TEST_F(UCIInfoTest, ResolvePV) {
+  Board board(8,8);
+  ASSERT_TRUE(board.LoadFEN("r3k2r/6P1/8/3pP3/8/8/8/R3K2R w KQkq d6 0 1"));
+  ASSERT_TRUE(Parse("info pv e5d6 e8c8 g7h8q c8d7 e1g1"));
+  ASSERT_EQ(PackedMove::QUIET, info_.pv[0].GetFlags());
+  ASSERT_TRUE(info_.ResolvePV(board));
+  ASSERT_EQ(5U, info_.pv_length);
+  ASSERT_TRUE(info_.pv[0].IsEnPassant());
+  ASSERT_EQ(PackedMove::LONG_CASTLE, info_.pv[1].GetFlags());
+  ASSERT_EQ(PackedMove::QUEEN_PROMOTION_CAPTURE, info_.pv[2].GetFlags());
+  ASSERT_EQ(PackedMove::SHORT_CASTLE, info_.pv[4].GetFlags());
+  ASSERT_EQ("e5d6 e8c8 g7h8q c8d7 e1g1", GetPV());
+
+  // cut at the first illegal move
+  ASSERT_TRUE(Parse("info pv e1g1 e8e6 a1a8"));
+  ASSERT_FALSE(info_.ResolvePV(board));
+  ASSERT_EQ(1U, info_.pv_length);
+}
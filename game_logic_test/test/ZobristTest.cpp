@@ -0,0 +1,114 @@
+/*
+ *  Chess
+ *  Copyright (C) 2014  A. Cortes
+ *  This program is under the terms of the GNU GPL v3
+ *  See LICENSE file in the root of this project
+ */
+#include "gtest/gtest.h"
+#include "Board.h"
+#include "MoveGenerator.h"
+
+using namespace std;
+using namespace acortes::chess;
+
+// the incremental key shall match the key computed from scratch after
+// every move and after taking it back
+static void CheckKeys(Board & board, int depth) {
+  MoveList moves;
+  MoveGenerator::GenerateLegalMoves(board, moves);
+  for(const auto & move : moves) {
+    MoveUndo undo;
+    uint64_t key = board.GetKey();
+    board.MakeMove(move, undo);
+    ASSERT_EQ(board.ComputeKey(), board.GetKey()) << move.UCI();
+    if(depth > 1) {
+      CheckKeys(board, depth - 1);
+    }
+    board.UnmakeMove(move, undo);
+    ASSERT_EQ(key, board.GetKey()) << move.UCI();
+  }
+}
+
+TEST(ZobristTest, IncrementalKeyMatchesComputedKey) {
+  Board board(8,8);
+  ASSERT_TRUE(board.LoadFEN("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"));
+  CheckKeys(board, 3);
+  ASSERT_TRUE(board.LoadFEN("rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"));
+  CheckKeys(board, 3);
+}
+
+TEST(ZobristTest, Transposition) {
+  Board board1(8,8);
+  Board board2(8,8);
+  MoveUndo undo;
+  board1.LoadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  board2.LoadFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+
+  // 1.Nf3 Nc6 2.Nc3 and 1.Nc3 Nc6 2.Nf3
+  board1.MakeMove(PackedMove(GetSquare(6, 0), GetSquare(5, 2)), undo);
+  board1.MakeMove(PackedMove(GetSquare(1, 7), GetSquare(2, 5)), undo);
+  board1.MakeMove(PackedMove(GetSquare(1, 0), GetSquare(2, 2)), undo);
+  board2.MakeMove(PackedMove(GetSquare(1, 0), GetSquare(2, 2)), undo);
+  board2.MakeMove(PackedMove(GetSquare(1, 7), GetSquare(2, 5)), undo);
+  board2.MakeMove(PackedMove(GetSquare(6, 0), GetSquare(5, 2)), undo);
+  ASSERT_EQ(board1.GetKey(), board2.GetKey());
+}
+
+TEST(ZobristTest, StateChangesKey) {
+  Board board(8,8);
+  board.LoadFEN("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  uint64_t key = board.GetKey();
+
+  board.SetSideToMove(Color::Dark);
+  ASSERT_NE(key, board.GetKey());
+  board.SetSideToMove(Color::Light);
+  ASSERT_EQ(key, board.GetKey());
+
+  board.SetCastlingRights(LIGHT_SHORT_CASTLE | DARK_SHORT_CASTLE);
+  ASSERT_NE(key, board.GetKey());
+  board.SetCastlingRights(ALL_CASTLING);
+  ASSERT_EQ(key, board.GetKey());
+
+  // no pawn can capture en passant
+  board.SetEnPassantSquare(GetSquare(4, 2));
+  ASSERT_EQ(key, board.GetKey());
+  ASSERT_EQ(board.ComputeKey(), board.GetKey());
+
+  board.LoadFEN("4k3/8/8/8/3pP3/8/8/4K3 b - - 0 1");
+  key = board.GetKey();
+  board.SetEnPassantSquare(GetSquare(4, 2));
+  ASSERT_NE(key, board.GetKey());
+  ASSERT_EQ(board.ComputeKey(), board.GetKey());
+  board.SetEnPassantSquare(-1);
+  ASSERT_EQ(key, board.GetKey());
+}
+
+TEST(ZobristTest, EnPassantOnlyWhenItCanBeCaptured) {
+  Board board1(8,8);
+  Board board2(8,8);
+  MoveUndo undo;
+  board1.LoadFEN(START_FEN);
+  board2.LoadFEN(START_FEN);
+
+  // 1.Nf3 e6 2.Ng1 e5 3.e4 and 1.e3 e5 2.e4, no black pawn can take
+  // on e3
+  board1.MakeMove(PackedMove(GetSquare(6, 0), GetSquare(5, 2)), undo);
+  board1.MakeMove(PackedMove(GetSquare(4, 6), GetSquare(4, 5)), undo);
+  board1.MakeMove(PackedMove(GetSquare(5, 2), GetSquare(6, 0)), undo);
+  board1.MakeMove(PackedMove(GetSquare(4, 5), GetSquare(4, 4)), undo);
+  board1.MakeMove(PackedMove(GetSquare(4, 1), GetSquare(4, 3), PackedMove::DOUBLE_PAWN_PUSH), undo);
+  board2.MakeMove(PackedMove(GetSquare(4, 1), GetSquare(4, 2)), undo);
+  board2.MakeMove(PackedMove(GetSquare(4, 6), GetSquare(4, 4), PackedMove::DOUBLE_PAWN_PUSH), undo);
+  board2.MakeMove(PackedMove(GetSquare(4, 2), GetSquare(4, 3)), undo);
+  ASSERT_EQ(GetSquare(4, 2), board1.GetEnPassantSquare());
+  ASSERT_EQ(board1.GetKey(), board2.GetKey());
+  board1.LoadFEN("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  board2.LoadFEN("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+  ASSERT_EQ(board1.GetKey(), board2.GetKey());
+
+  // with a black pawn on d4 the square counts
+  board1.LoadFEN("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+  board2.LoadFEN("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+  ASSERT_NE(board1.GetKey(), board2.GetKey());
+  ASSERT_EQ(board1.ComputeKey(), board1.GetKey());
+}